@@ -1,6 +1,16 @@
+/*
+  The MIT License (MIT)
+
+  ADC APIs
+
+  Configuration defines (can be changed in Makefile):
+	#define ADC_ENGINE // IRQ_ADC driven sampling of a channels list
+	#define ADC_ENGINE_CHANNELS 4 // max number of channels in the list
+*/
 #include <N76E003.h>
 
 #include "adc.h"
+#include "event.h"
 
 uint16_t adc_read(void)
 {
@@ -8,3 +18,105 @@ uint16_t adc_read(void)
 	return adc_val;
 }
 
+#ifdef ADC_ENGINE
+static __xdata uint8_t adc_list[ADC_ENGINE_CHANNELS];
+static __xdata uint16_t adc_acc[ADC_ENGINE_CHANNELS]; /* sums of the current set */
+static __xdata uint16_t adc_sum[ADC_ENGINE_CHANNELS]; /* sums of the last set */
+
+static uint8_t adc_num;		/* channels in the list */
+static uint8_t adc_idx;		/* channel being converted */
+static uint8_t adc_round;	/* samples of the current set per channel */
+static uint8_t adc_samples;	/* samples per set per channel */
+static uint8_t adc_os;		/* log2(adc_samples) */
+static uint8_t adc_mode;
+
+void adc_engine_start(__code const uint8_t *channels, uint8_t num, uint8_t oversample, uint8_t mode)
+{
+	uint8_t i;
+
+	cli_adc();
+	if (num > ADC_ENGINE_CHANNELS)
+		num = ADC_ENGINE_CHANNELS;
+	if (oversample > 4)
+		oversample = 4; /* 16 * 4095 fits into uint16_t */
+	for (i = 0; i < num; i++) {
+		adc_list[i] = channels[i];
+		adc_acc[i] = 0;
+		adc_sum[i] = 0;
+	}
+	adc_num = num;
+	adc_idx = 0;
+	adc_round = 0;
+	adc_os = oversample;
+	adc_samples = 1 << oversample;
+	adc_mode = mode;
+	if (num == 0)
+		return;
+
+	adc_enable();
+	adc_select_channel(adc_list[0]);
+	adc_clear();
+	sti_adc();
+	if (mode == ADC_EXT_TRIGGER) {
+		set_ADCEX; /* trigger source is kept in ADCCON0 and ADCCON1 */
+	} else {
+		clr_ADCEX;
+		adc_start();
+	}
+}
+
+void adc_engine_stop(void)
+{
+	cli_adc();
+	clr_ADCEX;
+	adc_clear();
+}
+
+uint16_t adc_engine_sum(uint8_t idx)
+{
+	uint16_t val;
+	__bit ie = EADC;
+
+	cli_adc();
+	val = adc_sum[idx];
+	EADC = ie;
+	return val;
+}
+
+uint16_t adc_engine_avg(uint8_t idx)
+{
+	return adc_engine_sum(idx) >> adc_os;
+}
+
+uint16_t adc_engine_dec(uint8_t idx)
+{
+	/* sum has 12 + adc_os bits, keep 12 + adc_os / 2 */
+	return adc_engine_sum(idx) >> ((adc_os + 1) >> 1);
+}
+
+void adc_interrupt_handler(void) INTERRUPT(IRQ_ADC, IRQ_ADC_REG_BANK)
+{
+	uint8_t i;
+
+	adc_clear();
+	adc_acc[adc_idx] += (ADCRH << 4) + ADCRL;
+	if (++adc_idx == adc_num) {
+		adc_idx = 0;
+		if (++adc_round == adc_samples) {
+			adc_round = 0;
+			for (i = 0; i < adc_num; i++) {
+				adc_sum[i] = adc_acc[i];
+				adc_acc[i] = 0;
+			}
+			event_put(EVT_ADC, ADC_SET);
+			if (adc_mode == ADC_ONE_SET) {
+				cli_adc();
+				return;
+			}
+		}
+	}
+	adc_select_channel(adc_list[adc_idx]);
+	if (adc_mode != ADC_EXT_TRIGGER)
+		adc_start();
+}
+#endif
@@ -1,8 +1,20 @@
+/*
+  The MIT License (MIT)
+
+  ADC APIs
+
+  Configuration defines (can be changed in Makefile):
+	#define ADC_ENGINE // IRQ_ADC driven sampling of a channels list, adc.c
+	#define ADC_ENGINE_CHANNELS 4 // max number of channels in the list
+	#define ADC_VDD_ASYNC // IRQ_ADC driven Vdd measurement, vdd.c
+*/
 #ifndef N76E003_ADC_H
 #define N76E003_ADC_H
 
 #include <N76E003.h>
 
+#include "irq.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -34,9 +46,68 @@ enum adc_channel_t {
 /* adc.c */
 uint16_t adc_read(void);
 
+#ifdef ADC_ENGINE
+#ifdef ADC_VDD_ASYNC
+#error "ADC_ENGINE and ADC_VDD_ASYNC share the ADC interrupt, add ADC_BAND_GAP to the engine channels and use adc_vdd_mv()"
+#endif
+#ifndef ADC_ENGINE_CHANNELS
+#define ADC_ENGINE_CHANNELS 4
+#endif
+
+/** EVT_ADC data when a set of all channels is sampled */
+#define ADC_SET 0x80
+
+enum adc_mode_t {
+	ADC_ONE_SET,	 /** sample one set and stop */
+	ADC_CONTINUOUS,	 /** start the next conversion from the ADC interrupt */
+	ADC_EXT_TRIGGER	 /** conversions started by PWM edge or STADC pin, */
+					 /** select the source before, e.g. PWM2_FALLINGEDGE_TRIG_ADC */
+};
+
+/**
+ * round-robin conversions of the channels list, each channel is sampled
+ * 2^oversample times per set and the sum is kept until the next set is done,
+ * EVT_ADC with ADC_SET data is posted per set
+ * @param channels list of ADC_AIN0 - ADC_BAND_GAP, pins must be configured as inputs
+ * @param num number of channels, up to ADC_ENGINE_CHANNELS
+ * @param oversample 0 - 4, 1 to 16 samples per channel
+ * @param mode one of adc_mode_t
+ */
+void adc_engine_start(__code const uint8_t *channels, uint8_t num, uint8_t oversample, uint8_t mode);
+
+void adc_engine_stop(void);
+
+/** sum of 2^oversample samples of the channel from the last set */
+uint16_t adc_engine_sum(uint8_t idx);
+
+/** average of the channel samples, 12 bits */
+uint16_t adc_engine_avg(uint8_t idx);
+
+/** decimated value with oversample / 2 extra bits of resolution, rounded down */
+uint16_t adc_engine_dec(uint8_t idx);
+
+void adc_interrupt_handler(void) INTERRUPT(IRQ_ADC, IRQ_ADC_REG_BANK);
+#endif
+
 /* vdd.c, requires iap_read.c */
 uint16_t adc_get_vdd(uint8_t mode);
 
+/** convert raw band-gap conversion to Vdd in mV, band-gap is read by adc_get_vdd() */
+uint16_t adc_vdd_mv(uint16_t raw);
+
+#ifdef ADC_VDD_ASYNC
+/** start ADC_VDD_SAMPLES band-gap conversions, EVT_ADC with ADC_BAND_GAP data when done */
+void adc_vdd_start(void);
+
+/** non zero while adc_vdd_start() conversions are running */
+uint8_t adc_vdd_busy(void);
+
+/** Vdd in mV measured by adc_vdd_start(), 0 if not finished yet */
+uint16_t adc_vdd_result(void);
+
+void adc_interrupt_handler(void) INTERRUPT(IRQ_ADC, IRQ_ADC_REG_BANK);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,37 @@
+/*
+  The MIT License (MIT)
+
+  Cycle exact busy-wait delays for constant intervals,
+  loops timing is described in delay.h, do not change the code
+  without updating DELAY_CALL and DELAY_PASS.
+*/
+#include <N76E003.h>
+
+#include "delay.h"
+
+/*
+  __naked functions are called without saving registers, so the counters
+  are kept in dpl/dph, which are free for a function with uint8_t argument
+*/
+void delay_loop(uint8_t n) __naked
+{
+	n; /* passed in dpl */
+	__asm
+00001$:
+	djnz	dpl,00001$
+	ret
+	__endasm;
+}
+
+void delay_loop_long(uint8_t n) __naked
+{
+	n; /* passed in dpl */
+	__asm
+00001$:
+	mov	dph,#0
+00002$:
+	djnz	dph,00002$
+	djnz	dpl,00001$
+	ret
+	__endasm;
+}
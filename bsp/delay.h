@@ -0,0 +1,99 @@
+/*
+  The MIT License (MIT)
+
+  Cycle exact busy-wait delays for constant intervals
+
+  delay_cycles(n) and delay_us(us) must be called with compile-time
+  constants, the macros select between the long and the short assembler
+  loops and pad the remainder with NOPs, so the code generated between the
+  macro start and end takes exactly 'n' system clocks including
+  call overhead. delay_us() is rounded to the nearest Fsys clock:
+  16 clocks per usec for FOSC_16000, 16.6 for FOSC_16600.
+
+  Configuration defines (can be changed in Makefile):
+    #define FOSC_16600 // system clock set to 16.600 MHz
+    #define DELAY_CORE_8051 // count classic 8051 machine cycles, used by pys/delay-s51.py
+*/
+#ifndef N76E003_DELAY_H
+#define N76E003_DELAY_H
+
+#include <N76E003.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * instruction timings in clocks, N76E003 datasheet "Instruction Set" table
+ * or classic 8051 machine cycles for s51 simulator verification.
+ * pys/delay-s51.py checks the macros with 8051 cycles only, N76E003
+ * timings are not verified yet: MARK; delay_us(1000); MARK; on the device
+ * must show 1 msec plus one MARK between the MARK_PIN pulses on a scope
+ */
+#ifndef DELAY_CORE_8051
+#define DELAY_T_MOV_DIR_IMM	3 /** mov direct,#data - argument load to dpl, counter load to dph */
+#define DELAY_T_LCALL		6
+#define DELAY_T_DJNZ		5 /** djnz direct,rel */
+#define DELAY_T_RET			4
+#else
+#define DELAY_T_MOV_DIR_IMM	2
+#define DELAY_T_LCALL		2
+#define DELAY_T_DJNZ		2
+#define DELAY_T_RET			2
+#endif
+
+/** fixed cost of a loop call: argument, call and return */
+#define DELAY_CALL (DELAY_T_MOV_DIR_IMM + DELAY_T_LCALL + DELAY_T_RET)
+/** one pass of delay_loop_long(): counter load, 256 inner iterations and outer djnz */
+#define DELAY_PASS (DELAY_T_MOV_DIR_IMM + 257 * DELAY_T_DJNZ)
+
+/** delay_loop_long() passes, 0 if delay is too short for it */
+#define DELAY_LONG_N(n) \
+	(((n) >= DELAY_CALL + DELAY_PASS) ? (((n) - DELAY_CALL) / DELAY_PASS) : 0)
+#define DELAY_LONG_REST(n) \
+	(DELAY_LONG_N(n) ? ((n) - DELAY_CALL - DELAY_LONG_N(n) * DELAY_PASS) : (n))
+
+/** delay_loop() iterations for the rest, 0 if the rest is too short for it */
+#define DELAY_SHORT_N(r) \
+	(((r) < DELAY_CALL + DELAY_T_DJNZ) ? 0 : \
+	(((r) - DELAY_CALL) / DELAY_T_DJNZ > 256) ? 256 : (((r) - DELAY_CALL) / DELAY_T_DJNZ))
+#define DELAY_SHORT_REST(r) \
+	(DELAY_SHORT_N(r) ? ((r) - DELAY_CALL - DELAY_SHORT_N(r) * DELAY_T_DJNZ) : (r))
+
+#define _delay_nops(r) do { \
+	if ((r) & 1) { nop(); } \
+	if ((r) & 2) { nop(); nop(); } \
+	if ((r) & 4) { nop(); nop(); nop(); nop(); } \
+	if ((r) & 8) { nop(); nop(); nop(); nop(); nop(); nop(); nop(); nop(); } \
+	if ((r) & 16) { nop(); nop(); nop(); nop(); nop(); nop(); nop(); nop(); \
+		nop(); nop(); nop(); nop(); nop(); nop(); nop(); nop(); } \
+} while (0)
+
+/**
+ * busy-wait exactly 'n' clocks, less than 256 * DELAY_PASS (~20 msec at 16 MHz),
+ * 'n' must be a constant, interrupts extend the delay
+ */
+#define delay_cycles(n) do { \
+	if (DELAY_LONG_N(n)) \
+		delay_loop_long((uint8_t)DELAY_LONG_N(n)); \
+	if (DELAY_SHORT_N(DELAY_LONG_REST(n))) \
+		delay_loop((uint8_t)DELAY_SHORT_N(DELAY_LONG_REST(n))); \
+	_delay_nops(DELAY_SHORT_REST(DELAY_LONG_REST(n))); \
+} while (0)
+
+/** number of Fsys clocks in 'us' microseconds, rounded */
+#define DELAY_US_CYCLES(us) (((us) * (HIRC_FREQ / 1000UL) + 500UL) / 1000UL)
+
+/** busy-wait 'us' microseconds, 'us' must be a constant */
+#define delay_us(us) delay_cycles(DELAY_US_CYCLES(us))
+
+/** djnz loop on dpl, 'n' iterations, 0 is 256, use delay_cycles() instead */
+void delay_loop(uint8_t n) __naked;
+/** 'n' passes of 256 djnz iterations on dph, use delay_cycles() instead */
+void delay_loop_long(uint8_t n) __naked;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
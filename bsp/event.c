@@ -3,33 +3,72 @@
 #include "irq.h"
 #include "event.h"
 
-#define EVENT_NUM	64 /** must be power of 2 */
-#define EVENT_BUF_SIZE (EVENT_NUM * 2) /** each event takes 2 bytes */
-#define EVENT_BUF_MASK (EVENT_BUF_SIZE - 1)
+/** each event takes 2 bytes, lanes are located one after another in evt_buf */
+#define LANE_SIZE(num) ((num) * 2)
 
-static uint8_t evt_put; /** position to put even in */
-static uint8_t evt_get; /** position to get even from */
-static volatile uint8_t evt_num; /** number of events in the buffer */
+#if EVENT_LANES == 1
+#define EVENT_BUF_SIZE LANE_SIZE(EVENT_NUM)
+static const __code uint8_t lane_num[] = { EVENT_NUM };
+static const __code uint8_t lane_base[] = { 0 };
+#elif EVENT_LANES == 2
+#define EVENT_BUF_SIZE (LANE_SIZE(EVENT_HIGH_NUM) + LANE_SIZE(EVENT_NORMAL_NUM))
+static const __code uint8_t lane_num[] = { EVENT_HIGH_NUM, EVENT_NORMAL_NUM };
+static const __code uint8_t lane_base[] = { 0, LANE_SIZE(EVENT_HIGH_NUM) };
+#elif EVENT_LANES == 3
+#define EVENT_BUF_SIZE (LANE_SIZE(EVENT_HIGH_NUM) + LANE_SIZE(EVENT_NORMAL_NUM) + LANE_SIZE(EVENT_LOW_NUM))
+static const __code uint8_t lane_num[] = { EVENT_HIGH_NUM, EVENT_NORMAL_NUM, EVENT_LOW_NUM };
+static const __code uint8_t lane_base[] = { 0, LANE_SIZE(EVENT_HIGH_NUM),
+	LANE_SIZE(EVENT_HIGH_NUM) + LANE_SIZE(EVENT_NORMAL_NUM) };
+#else
+#error "EVENT_LANES must be 1, 2 or 3"
+#endif
+
+#if EVENT_BUF_SIZE > 256
+#error "events buffer is limited to 128 events in all lanes"
+#endif
+
+static uint8_t evt_put[EVENT_LANES]; /** position to put event in */
+static uint8_t evt_get[EVENT_LANES]; /** position to get event from */
+static volatile uint8_t evt_num[EVENT_LANES]; /** number of events in the lane */
+static volatile uint8_t evt_drop[EVENT_LANES]; /** dropped events counter */
 static volatile uint8_t evt_err; /** overflow error */
 
-static __xdata uint8_t evt_buf[EVENT_NUM * 2];
+static __xdata uint8_t evt_buf[EVENT_BUF_SIZE];
 
 #pragma save
 #pragma nooverlay
 
-void event_put(uint8_t type, uint8_t data) __reentrant __using(IRQ_REG_BANK)
+bool event_put(uint8_t type, uint8_t data) __reentrant __using(IRQ_REG_BANK)
 {
-	if (evt_num == EVENT_NUM) {
+	uint8_t lane = EVENT_LANE(type);
+	__xdata uint8_t *buf;
+
+	if (EVENT_COALESCE(type) && evt_num[lane]) {
+		/* merge with the last queued event of the same type, data is accumulated */
+		buf = evt_buf + lane_base[lane] + ((evt_put[lane] - 2) & (LANE_SIZE(lane_num[lane]) - 1));
+		if (buf[0] == type) {
+			if (data > (uint8_t)~buf[1])
+				buf[1] = 0xFF;
+			else
+				buf[1] += data;
+			return true;
+		}
+	}
+
+	if (evt_num[lane] == lane_num[lane]) {
 		if (evt_err == EVT_NONE)
 			evt_err = type;
-	} else {
-		/* use a pointer to generate smaller code */
-		__xdata uint8_t *buf = evt_buf + evt_put;
-		buf[0] = type;
-		buf[1] = data;
-		evt_put = (evt_put + 2) & EVENT_BUF_MASK;
-		evt_num = evt_num + 1;
+		if (evt_drop[lane] != 0xFF)
+			evt_drop[lane] += 1;
+		return false;
 	}
+	/* use a pointer to generate smaller code */
+	buf = evt_buf + lane_base[lane] + evt_put[lane];
+	buf[0] = type;
+	buf[1] = data;
+	evt_put[lane] = (evt_put[lane] + 2) & (LANE_SIZE(lane_num[lane]) - 1);
+	evt_num[lane] = evt_num[lane] + 1;
+	return true;
 }
 
 #pragma restore
@@ -37,29 +76,45 @@ void event_put(uint8_t type, uint8_t data) __reentrant __using(IRQ_REG_BANK)
 uint16_t event_get(void)
 {
 	event_t event;
+	uint8_t lane;
+
+	/* the first lane with events has the highest priority */
+	for (lane = 0; lane < EVENT_LANES; lane++)
+		if (evt_num[lane])
+			break;
 
-	if (evt_num == 0)
+	if (lane == EVENT_LANES)
 		event.type = EVT_NONE;
 	else if (evt_err) {
 		event.type = EVT_ERROR;
 		event.data = evt_err;
 		evt_err = 0;
 	} else {
-		__xdata uint8_t *buf = evt_buf + evt_get;
+		__xdata uint8_t *buf = evt_buf + lane_base[lane] + evt_get[lane];
+		/* event_put() can merge new data to the last event */
+		cli();
 		event.type = buf[0];
 		event.data = buf[1];
-		cli();
-		evt_num -= 1;
+		evt_num[lane] -= 1;
 		sti();
-		evt_get = (evt_get + 2) & EVENT_BUF_MASK;
+		evt_get[lane] = (evt_get[lane] + 2) & (LANE_SIZE(lane_num[lane]) - 1);
 	}
 
 	return event.evt;
 }
 
+uint8_t event_dropped(uint8_t lane)
+{
+	return evt_drop[lane];
+}
+
 void event_flush(void)
 {
+	uint8_t lane;
+
 	cli();
-	evt_put = evt_get =	evt_num = evt_err = 0;
+	for (lane = 0; lane < EVENT_LANES; lane++)
+		evt_put[lane] = evt_get[lane] = evt_num[lane] = evt_drop[lane] = 0;
+	evt_err = 0;
 	sti();
 }
@@ -2,6 +2,7 @@
 #define N76E003_EVENT_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,17 +35,79 @@ enum EVENT_TYPE {
 	EVT_I2C_STAT, /** 4 I2C status byte */
 	EVT_PIN_LOW,  /** 5 Pin status byte */
 	EVT_PIN_HIGH, /** 6 Pin status byte */
-	EVT_TICK,	  /** 7 timer event */
+	EVT_TICK,	  /** 7 timer event, number of passed intervals */
+	EVT_UART_TX,  /** 8 UART block descriptor transmitted */
+	EVT_UART_LINE, /** 9 UART line received, see UART_RX_RING */
+	EVT_ADC,	  /** 10 ADC measurement done, data: channel or ADC_SET */
+	EVT_PWM_RAMP, /** 11 PWM ramp reached the target, data: channel */
+	EVT_PIN_FRAME, /** 12 pindec.c frame received, data: decoder and length, see pindec.h */
+	EVT_SPI,	  /** 13 SPI block transferred, data: spi_submit() tag */
+	EVT_SPI_FRAME, /** 14 SPI slave frame received, data: number of bytes */
 };
 
+/**
+ * Events can be split to priority lanes, event_get() returns events
+ * from the high lane first, so a burst of UART or tick events
+ * does not delay pin events. Each lane has its own depth and
+ * dropped events counter. Configuration defines (can be set in Makefile):
+ *	#define EVENT_LANES 1        // 1 - single FIFO, 2 - high and normal, 3 - high, normal and low
+ *	#define EVENT_NUM 64         // single lane depth
+ *	#define EVENT_HIGH_NUM 16    // high lane depth: EVT_PIN_LOW, EVT_PIN_HIGH, EVT_PIN_FRAME
+ *	#define EVENT_NORMAL_NUM 32  // normal lane depth: all other events
+ *	#define EVENT_LOW_NUM 16     // low lane depth: EVT_TICK
+ *	#define EVENT_LANE(type)     // expression to select a lane for the event type
+ * Lane depths must be power of 2, all lanes together are limited to 128 events.
+ */
+#ifndef EVENT_LANES
+#define EVENT_LANES 1
+#endif
+
+#ifndef EVENT_NUM
+#define EVENT_NUM 64
+#endif
+#ifndef EVENT_HIGH_NUM
+#define EVENT_HIGH_NUM 16
+#endif
+#ifndef EVENT_NORMAL_NUM
+#define EVENT_NORMAL_NUM 32
+#endif
+#ifndef EVENT_LOW_NUM
+#define EVENT_LOW_NUM 16
+#endif
+
+#define EVT_LANE_HIGH	0
+#define EVT_LANE_NORMAL (EVENT_LANES > 1)
+#define EVT_LANE_LOW	(EVENT_LANES - 1)
+
+#ifndef EVENT_LANE
+#define EVENT_LANE(type) \
+	(((type) == EVT_PIN_LOW || (type) == EVT_PIN_HIGH || (type) == EVT_PIN_FRAME) ? EVT_LANE_HIGH : \
+	((type) == EVT_TICK) ? EVT_LANE_LOW : EVT_LANE_NORMAL)
+#endif
+
+/**
+ * Coalescable events are merged with the last queued event of the same
+ * type in the lane: data is added (saturated at 255) instead of appending
+ * a new event. By default EVT_TICK is coalescable and its data is a number
+ * of passed tick intervals. Set in Makefile to select other event types:
+ *	#define EVENT_COALESCE(type) ((type) == EVT_TICK)
+ */
+#ifndef EVENT_COALESCE
+#define EVENT_COALESCE(type) ((type) == EVT_TICK)
+#endif
+
 /**
  * put event to the buffer, designed to be called only from ISRs
+ * @return false if the lane is full and the event is dropped
  */
-void event_put(uint8_t type, uint8_t data) __reentrant __using(IRQ_REG_BANK);
+bool event_put(uint8_t type, uint8_t data) __reentrant __using(IRQ_REG_BANK);
 
 /** get event from the events buffer */
 uint16_t event_get(void);
 
+/** number of events dropped in the lane since event_flush(), saturates at 255 */
+uint8_t event_dropped(uint8_t lane);
+
 /** clear the events buffer */
 void event_flush(void);
 
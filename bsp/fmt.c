@@ -0,0 +1,133 @@
+/*
+  The MIT License (MIT)
+
+  Division free decimal formatting of 16 and 32 bit numbers
+*/
+#include <stdint.h>
+
+#include "fmt.h"
+
+/** number of digits of uint32_t */
+#define FMT_DIGITS 10
+
+__xdata char fmt_buf[FMT_BUF_SIZE];
+
+/* digits right aligned with leading '0' */
+static __xdata char digits[FMT_DIGITS];
+
+static const __code uint16_t pow10_16[] = {10000, 1000, 100, 10};
+static const __code uint32_t pow10_32[] = {
+	1000000000, 100000000, 10000000, 1000000, 100000, 10000
+};
+
+/** fill digits from digits[FMT_DIGITS - 5 + i] for pow10_16[i] and lower */
+static void digits16(uint16_t val, uint8_t i)
+{
+	uint16_t pow;
+	char d;
+
+	for (; i < 4; i++) {
+		pow = pow10_16[i];
+		for (d = '0'; val >= pow; d++)
+			val -= pow;
+		digits[FMT_DIGITS - 5 + i] = d;
+	}
+	digits[FMT_DIGITS - 1] = '0' + (uint8_t)val;
+}
+
+static void digits32(uint32_t val)
+{
+	uint32_t pow;
+	uint8_t i;
+	char d;
+
+	if (val <= 0xFFFF) {
+		for (i = 0; i < FMT_DIGITS - 5; i++)
+			digits[i] = '0';
+		digits16((uint16_t)val, 0);
+		return;
+	}
+	/* remainder below 10000 fits into 16 bits */
+	for (i = 0; i < FMT_DIGITS - 4; i++) {
+		pow = pow10_32[i];
+		for (d = '0'; val >= pow; d++)
+			val -= pow;
+		digits[i] = d;
+	}
+	digits16((uint16_t)val, 1);
+}
+
+/** copy digits to fmt_buf with the sign, padding and decimal point */
+static uint8_t pack(uint8_t neg, uint8_t dec, uint8_t width, uint8_t flags)
+{
+	uint8_t i, n, len = 0;
+	char pad = (flags & FMT_ZERO) ? '0' : ' ';
+
+	if (dec > FMT_DIGITS - 1)
+		dec = FMT_DIGITS - 1;
+	if (width > FMT_BUF_SIZE - 1)
+		width = FMT_BUF_SIZE - 1;
+	/* skip leading zeros, keep one digit before the decimal point */
+	for (i = 0; i < FMT_DIGITS - 1 - dec && digits[i] == '0'; i++);
+
+	n = FMT_DIGITS - i + neg;
+	if (dec)
+		n++;
+	if (neg && pad == '0')
+		fmt_buf[len++] = '-';
+	for (; n < width; n++)
+		fmt_buf[len++] = pad;
+	if (neg && pad != '0')
+		fmt_buf[len++] = '-';
+
+	for (; i < FMT_DIGITS; i++) {
+		if (dec && i == FMT_DIGITS - dec)
+			fmt_buf[len++] = '.';
+		fmt_buf[len++] = digits[i];
+	}
+	fmt_buf[len] = '\0';
+	return len;
+}
+
+uint8_t fmt_u16(uint16_t val, uint8_t width, uint8_t flags)
+{
+	uint8_t i;
+
+	for (i = 0; i < FMT_DIGITS - 5; i++)
+		digits[i] = '0';
+	digits16(val, 0);
+	return pack(0, 0, width, flags);
+}
+
+uint8_t fmt_s16(int16_t val, uint8_t width, uint8_t flags)
+{
+	uint8_t i;
+	uint8_t neg = 0;
+
+	if (val < 0) {
+		neg = 1;
+		val = -val; /* -32768 stays 0x8000 and is correct as uint16_t */
+	}
+	for (i = 0; i < FMT_DIGITS - 5; i++)
+		digits[i] = '0';
+	digits16((uint16_t)val, 0);
+	return pack(neg, 0, width, flags);
+}
+
+uint8_t fmt_u32(uint32_t val, uint8_t width, uint8_t flags)
+{
+	digits32(val);
+	return pack(0, 0, width, flags);
+}
+
+uint8_t fmt_fixed(int32_t val, uint8_t dec, uint8_t width, uint8_t flags)
+{
+	uint8_t neg = 0;
+
+	if (val < 0) {
+		neg = 1;
+		val = -val;
+	}
+	digits32((uint32_t)val);
+	return pack(neg, dec, width, flags);
+}
@@ -0,0 +1,50 @@
+/*
+  The MIT License (MIT)
+
+  Division free decimal formatting of 16 and 32 bit numbers
+
+  Digits are produced by subtraction of decimal powers from __code tables,
+  at most 9 subtractions per digit instead of 16/32 bit division calls.
+  Result is placed to the shared fmt_buf, so formatting must not be used
+  from interrupt handlers.
+*/
+#ifndef N76E003_FMT_H
+#define N76E003_FMT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** sign, 10 digits of uint32_t, decimal point and '\0' */
+#define FMT_BUF_SIZE 13
+
+/** flags */
+#define FMT_ZERO 0x01 /** pad with '0' after the sign instead of leading spaces */
+
+/** formatted number string, valid until the next fmt_* call */
+extern __xdata char fmt_buf[FMT_BUF_SIZE];
+
+/**
+ * all functions write fmt_buf and return its length
+ * @param width minimum length, the number is right aligned, 0 for left aligned
+ * @param flags FMT_ZERO or 0
+ */
+uint8_t fmt_u16(uint16_t val, uint8_t width, uint8_t flags);
+uint8_t fmt_s16(int16_t val, uint8_t width, uint8_t flags);
+uint8_t fmt_u32(uint32_t val, uint8_t width, uint8_t flags);
+
+/**
+ * fixed point number, fmt_fixed(-1234, 2, 0, 0) gives "-12.34"
+ * @param dec number of digits after the decimal point, 0 for integer
+ */
+uint8_t fmt_fixed(int32_t val, uint8_t dec, uint8_t width, uint8_t flags);
+
+#define fmt_s32(val, width, flags) fmt_fixed(val, 0, width, flags)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,160 @@
+/*
+  The MIT License (MIT)
+
+  Interrupt driven I2C master transactions queue for N76E003
+
+  Configuration defines (can be changed in Makefile):
+    #define I2C_QUEUE_SIZE 4 // must be power of two
+*/
+#include <N76E003.h>
+
+#include "event.h"
+#include "prof.h"
+#include "i2c_queue.h"
+
+#define I2C_QUEUE_MASK (I2C_QUEUE_SIZE - 1)
+
+/* I2STAT master mode status codes */
+#define I2C_MT_START	0x08 /** START transmitted */
+#define I2C_MT_RESTART	0x10 /** repeated START transmitted */
+#define I2C_MT_SLA_ACK	0x18 /** SLA+W transmitted, ACK received */
+#define I2C_MT_SLA_NACK	0x20 /** SLA+W transmitted, NACK received */
+#define I2C_MT_DATA_ACK	0x28 /** data transmitted, ACK received */
+#define I2C_MT_DATA_NACK 0x30 /** data transmitted, NACK received */
+#define I2C_M_ARB_LOST	0x38 /** arbitration lost */
+#define I2C_MR_SLA_ACK	0x40 /** SLA+R transmitted, ACK received */
+#define I2C_MR_SLA_NACK	0x48 /** SLA+R transmitted, NACK received */
+#define I2C_MR_DATA_ACK	0x50 /** data received, ACK returned */
+#define I2C_MR_DATA_NACK 0x58 /** data received, NACK returned */
+
+typedef struct {
+	uint8_t dev;	/** device address */
+	uint8_t flags;	/** tag and I2C_XFER_NOEVT */
+	uint8_t wlen;	/** number of bytes to write */
+	uint8_t rlen;	/** number of bytes to read */
+	__xdata uint8_t *wbuf;
+	__xdata uint8_t *rbuf;
+} i2c_xfer_t;
+
+static uint8_t xq_head;			 /** transaction in progress */
+static volatile uint8_t xq_num;	 /** number of queued transactions */
+static uint8_t xidx;			 /** byte index within current transaction */
+
+static __xdata i2c_xfer_t xq_buf[I2C_QUEUE_SIZE];
+
+void i2c_interrupt_handler(void) INTERRUPT(IRQ_I2C, IRQ_I2C_REG_BANK)
+{
+	__xdata i2c_xfer_t *xfer = xq_buf + xq_head;
+	uint8_t status = I2C_XFER_OK;
+	PROF_ENTER();
+
+	if (I2TOC & SET_BIT0) { /* I2TOF: SI was not set in time */
+		clr_I2TOF;
+		status = I2C_XFER_ETIMEOUT;
+		goto done;
+	}
+
+	switch (I2STAT) {
+	case I2C_MT_START:
+		STA = 0;
+		xidx = 0;
+		/* address only probe is SLA+W followed by STOP */
+		if (xfer->wlen || !xfer->rlen)
+			I2DAT = xfer->dev & ~I2C_READ;
+		else
+			I2DAT = xfer->dev | I2C_READ;
+		break;
+	case I2C_MT_RESTART:
+		STA = 0;
+		xidx = 0;
+		I2DAT = xfer->dev | I2C_READ;
+		break;
+	case I2C_MT_SLA_ACK:
+	case I2C_MT_DATA_ACK:
+		if (xidx < xfer->wlen) {
+			I2DAT = xfer->wbuf[xidx];
+			xidx++;
+			break;
+		}
+		if (xfer->rlen) {
+			STA = 1; /* re-start to switch to reading */
+			break;
+		}
+		goto done;
+	case I2C_MR_SLA_ACK:
+		/* NACK the only byte to read */
+		AA = (xfer->rlen > 1);
+		break;
+	case I2C_MR_DATA_ACK:
+		xfer->rbuf[xidx] = I2DAT;
+		xidx++;
+		/* NACK the last byte to read */
+		AA = ((uint8_t)(xidx + 1) < xfer->rlen);
+		break;
+	case I2C_MR_DATA_NACK:
+		xfer->rbuf[xidx] = I2DAT;
+		goto done;
+	case I2C_MT_SLA_NACK:
+	case I2C_MR_SLA_NACK:
+		status = I2C_XFER_ENACK;
+		goto done;
+	case I2C_MT_DATA_NACK:
+		status = I2C_XFER_EDATA;
+		goto done;
+	default: /* I2C_M_ARB_LOST, bus error 0x00 or unexpected slave codes */
+		status = I2C_XFER_EBUS;
+		goto done;
+	}
+	SI = 0;
+	PROF_EXIT(PROF_I2C);
+	return;
+
+done:
+	if (!(xfer->flags & I2C_XFER_NOEVT))
+		event_put(EVT_I2C_STAT, (xfer->flags << 4) | status);
+	xq_head = (xq_head + 1) & I2C_QUEUE_MASK;
+	xq_num -= 1;
+	STO = 1;
+	if (xq_num)
+		STA = 1; /* STOP followed by START of the next transaction */
+	else {
+		clr_I2TOCEN;
+		cli_i2c(); /* return I2C to polling mode for blocking calls */
+	}
+	SI = 0;
+	PROF_EXIT(PROF_I2C);
+}
+
+int8_t i2cq_submit(uint8_t dev, __xdata uint8_t *wbuf, uint8_t wlen,
+	__xdata uint8_t *rbuf, uint8_t rlen, uint8_t flags)
+{
+	if (xq_num == I2C_QUEUE_SIZE)
+		return I2C_EBUSY;
+
+	cli_i2c();
+	__xdata i2c_xfer_t *xfer = xq_buf + ((xq_head + xq_num) & I2C_QUEUE_MASK);
+	xfer->dev = dev;
+	xfer->flags = flags & (I2C_XFER_TAG_MASK | I2C_XFER_NOEVT);
+	xfer->wlen = wlen;
+	xfer->rlen = rlen;
+	xfer->wbuf = wbuf;
+	xfer->rbuf = rbuf;
+	xq_num += 1;
+	if (xq_num == 1) { /* queue was idle, start the transaction */
+		clr_I2TOF;
+		set_I2TOCEN; /* Fsys/1 time-out counter, ~1 msec per bus state */
+		STA = 1;
+	}
+	sti_i2c();
+	return I2C_EOK;
+}
+
+bool i2cq_busy(void)
+{
+	return xq_num != 0;
+}
+
+void i2cq_wait(void)
+{
+	while (xq_num);
+}
@@ -0,0 +1,81 @@
+/*
+  The MIT License (MIT)
+
+  Interrupt driven I2C master transactions queue for N76E003
+
+  Configuration defines (can be changed in Makefile):
+    #define I2C_QUEUE_SIZE 4 // must be power of two
+*/
+#ifndef N76E003_I2C_QUEUE_H
+#define N76E003_I2C_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "irq.h"
+#include "i2c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** number of transactions in the queue, located in xdata, must be power of 2 */
+#ifndef I2C_QUEUE_SIZE
+#define I2C_QUEUE_SIZE 4
+#endif
+
+#define I2C_EBUSY -5 /** transactions queue is full */
+
+/**
+ * i2cq_submit() flags:
+ * low 4 bits is a transaction tag returned in EVT_I2C_STAT event
+ */
+#define I2C_XFER_TAG_MASK 0x0F
+#define I2C_XFER_NOEVT	  0x80 /** do not generate EVT_I2C_STAT on completion */
+
+/**
+ * EVT_I2C_STAT event data:
+ * high 4 bits - transaction tag, low 4 bits - one of I2C_XFER_* status below
+ */
+#define I2C_XFER_OK		  0x00 /** transaction completed */
+#define I2C_XFER_ENACK	  0x01 /** device address was not acknowledged */
+#define I2C_XFER_EDATA	  0x02 /** written data byte was not acknowledged */
+#define I2C_XFER_EBUS	  0x03 /** bus error or arbitration lost */
+#define I2C_XFER_ETIMEOUT 0x04 /** I2C time-out counter expired */
+
+#define i2c_xfer_tag(data)	  ((data) >> 4)
+#define i2c_xfer_status(data) ((data) & 0x0F)
+
+void i2c_interrupt_handler(void) INTERRUPT(IRQ_I2C, IRQ_I2C_REG_BANK);
+
+/**
+ * Queue I2C transaction: START, write 'wlen' bytes, re-START, read 'rlen' bytes, STOP.
+ * If 'wlen' is 0 then read starts right after START, if 'rlen' is 0 then
+ * transaction stops after writing. If both are 0 then only SLA+W is sent
+ * to probe the device, I2C_XFER_ENACK is reported if it is not present.
+ * Buffers must stay valid until EVT_I2C_STAT.
+ * Bus must be initialized with i2c_init() first. Blocking i2c_* calls
+ * must not be used while i2cq_busy() returns true.
+ *
+ * @param dev device address, I2C_READ/I2C_WRITE bit is ignored
+ * @param wbuf data to write
+ * @param wlen number of bytes to write
+ * @param rbuf buffer for data to read
+ * @param rlen number of bytes to read
+ * @param flags transaction tag and I2C_XFER_NOEVT
+ * @return I2C_EOK or I2C_EBUSY if queue is full
+ */
+int8_t i2cq_submit(uint8_t dev, __xdata uint8_t *wbuf, uint8_t wlen,
+	__xdata uint8_t *rbuf, uint8_t rlen, uint8_t flags);
+
+/** true if transactions are pending or in progress */
+bool i2cq_busy(void);
+
+/** wait for queued transactions to finish, call before blocking i2c_* calls */
+void i2cq_wait(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -38,6 +38,8 @@ enum IRQ_NUM {
 #define IRQ_PIN_REG_BANK	IRQ_REG_BANK
 #define IRQ_WKT_REG_BANK	IRQ_REG_BANK
 #define IRQ_PWM_REG_BANK 	IRQ_REG_BANK
+#define IRQ_ADC_REG_BANK	IRQ_REG_BANK
+#define IRQ_SPI_REG_BANK	IRQ_REG_BANK
 
 /*--------------------------------------------------------------------------
   Some defines to make VS-Code IntelliSense happy
@@ -91,6 +93,7 @@ enum IRQ_NUM {
 #define cli_cap()	EIE &= ~EIE_ECAP /** Disable input capture interrupt */
 #define cli_pin()	EIE &= ~EIE_EPI	 /** Disable pin interrupt */
 #define cli_i2c()	EIE &= ~EIE_EI2C /** Disable I2C interrupt */
+#define cli_adc()	EADC = 0		 /** Disable ADC interrupt */
 
 #define sti_tim2()	EIE |= EIE_ET2	 /** Enable Timer 2 interrupt */
 #define sti_spi()	EIE |= EIE_ESPI	 /** Enable SPI interrupt */
@@ -100,6 +103,7 @@ enum IRQ_NUM {
 #define sti_cap()	EIE |= EIE_ECAP	 /** Enable input capture interrupt */
 #define sti_pin()	EIE |= EIE_EPI	 /** Enable pin interrupt */
 #define sti_i2c()	EIE |= EIE_EI2C	 /** Enable I2C interrupt */
+#define sti_adc()	EADC = 1		 /** Enable ADC interrupt */
 
 //#define sw_reset() EA=0;TA=0xAA;TA=0x55;CHPCON|=SET_BIT7
 #define sw_reset() __asm__("clr	_EA\n mov _TA,#0xAA\n mov _TA,#0x55\n orl _CHPCON,#0x80")
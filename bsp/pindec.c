@@ -0,0 +1,312 @@
+/*
+  The MIT License (MIT)
+
+  Clock and data serial decoders on top of pin interrupt,
+  see pindec.h for configuration defines
+*/
+#include <N76E003.h>
+
+#include "pindec.h"
+#include "prof.h"
+#if PINDEC_GAP
+#include "tick.h"
+#endif
+#ifdef PINDEC_PS2
+#include "delay.h"
+#endif
+
+#if (PINDEC_RING & (PINDEC_RING - 1)) || (PINDEC_RING > 128)
+#error "PINDEC_RING must be power of 2 up to 128"
+#endif
+
+static __xdata uint8_t ring[PINDEC_RING];
+static volatile uint8_t ring_head; /* written by the interrupt */
+static volatile uint8_t ring_tail; /* read by pindec_get() */
+
+#define ring_put(b) ring[ring_head++ & (PINDEC_RING - 1)] = (b)
+
+#if PINDEC_GAP
+static uint8_t now; /* milli8 at the interrupt */
+/** true if the decoder clock stopped for more than PINDEC_GAP msec */
+#define gap(last) ((uint8_t)(now - (last)) > PINDEC_GAP)
+#endif
+
+/** checks the ring room, posts the overflow error if the frame does not fit */
+static bool frame_begin(uint8_t id, uint8_t len) __using(IRQ_PIN_REG_BANK)
+{
+	if ((uint8_t)(PINDEC_RING - (uint8_t)(ring_head - ring_tail)) >= len)
+		return true;
+	event_put(EVT_PIN_FRAME, id | PINDEC_ERR | PINDEC_EOVERFLOW);
+	return false;
+}
+
+#ifdef PINDEC_PS2
+static __bit ps2_cmd;		/** sending a command */
+static __bit ps2_ack;		/** command sent, waiting for the reply */
+static uint8_t ps2_data;	/** data to send/receive */
+static uint8_t ps2_clock;	/** clock counter */
+static uint8_t ps2_parity;	/** parity counter */
+#if PINDEC_GAP
+static uint8_t ps2_last;
+#endif
+
+static void ps2_error(uint8_t err) __using(IRQ_PIN_REG_BANK)
+{
+	event_put(EVT_PIN_FRAME, PINDEC_PS2_ID | PINDEC_ERR | err);
+	ps2_ack = 0; /* no reply to wait for */
+	ps2_clock = ps2_data = 0;
+}
+
+/** PS/2 clock falling edge */
+static void ps2_edge(void) __using(IRQ_PIN_REG_BANK)
+{
+	/* send command mode */
+	if (ps2_cmd) {
+		ps2_clock++;
+		if (ps2_clock == 1) { /* start bit */
+			PS2_DAT = 0;
+			return;
+		}
+		if (ps2_clock < 10) { /* sending data out */
+			ps2_parity += ps2_data & 0x01;
+			PS2_DAT = ps2_data & 0x01;
+			ps2_data >>= 1;
+			return;
+		}
+		if (ps2_clock == 10) { /* send parity */
+			PS2_DAT = ps2_parity & 0x01;
+			return;
+		}
+		if (ps2_clock == 11) { /* stop bit */
+			PS2_DAT = 1;
+			return;
+		}
+		/* ps2_clock == 12: ack bit, PS2_DAT should be 0 */
+		ps2_cmd = 0;
+		if (PS2_DAT) {
+			ps2_error(PINDEC_EACK);
+			return;
+		}
+		ps2_clock = ps2_data = 0;
+		return;
+	}
+
+	/* receive data mode */
+#if PINDEC_GAP
+	if (ps2_clock && gap(ps2_last))
+		ps2_error(PINDEC_EGAP);
+	ps2_last = now;
+#endif
+	if (!ps2_clock) {
+		if (!PS2_DAT) { /* start data bit should be low */
+			ps2_clock++;
+			ps2_parity = 1; /* init with 1 to calculate odd parity */
+		} else {
+			ps2_error(PINDEC_ESTART);
+		}
+		return;
+	}
+	if (ps2_clock < 9) { /* receive data */
+		if (PS2_DAT) {
+			ps2_data |= 1 << (ps2_clock - 1);
+			ps2_parity++;
+		}
+		ps2_clock++;
+		return;
+	}
+	if (ps2_clock == 9) { /* check parity bit */
+		if ((ps2_parity & 0x01) != PS2_DAT) {
+			ps2_error(PINDEC_EPARITY);
+			return;
+		}
+		ps2_clock++;
+		return;
+	}
+	/* ps2_clock == 10: stop bit should be high for valid transaction */
+	if (!PS2_DAT) {
+		ps2_error(PINDEC_ESTOP);
+		return;
+	}
+	if (frame_begin(PINDEC_PS2_ID, 1)) {
+		ring_put(ps2_data);
+		event_put(EVT_PIN_FRAME, PINDEC_PS2_ID | 1);
+	}
+	ps2_ack = 0; /* any byte is the reply */
+	ps2_clock = ps2_data = 0;
+}
+
+void pindec_ps2_send(uint8_t cmd)
+{
+	cli_pin();
+	ps2_parity = 1;
+	ps2_cmd = 1;
+	ps2_ack = 1; /* wait for the reply byte */
+	ps2_clock = 0;
+	ps2_data = cmd;
+
+	/* prepare for start condition */
+	PS2_DAT = 1;
+	PS2_CLK = 1;
+	delay_us(100);
+
+	PS2_CLK = 0;
+	delay_us(100);
+	PS2_DAT = 0;
+
+	/* set clock high so the device will take over and generate the clock */
+	PS2_CLK = 1;
+	sti_pin();
+}
+
+bool pindec_ps2_pending(void)
+{
+	return ps2_ack;
+}
+#endif
+
+#ifdef PINDEC_WIEGAND
+#if WIEGAND_BITS > 40
+#error "WIEGAND_BITS must be up to 40"
+#endif
+#define WIEGAND_LEN ((WIEGAND_BITS + 7) / 8)
+
+static __xdata uint8_t wg_buf[WIEGAND_LEN];
+static uint8_t wg_bits;
+#if PINDEC_GAP
+static uint8_t wg_last;
+#endif
+
+/** D0 or D1 pulse, bits are left aligned MSB first */
+static void wiegand_bit(uint8_t bit) __using(IRQ_PIN_REG_BANK)
+{
+	uint8_t i;
+
+#if PINDEC_GAP
+	if (wg_bits && gap(wg_last)) {
+		event_put(EVT_PIN_FRAME, PINDEC_WIEGAND_ID | PINDEC_ERR | PINDEC_EGAP);
+		wg_bits = 0;
+	}
+	wg_last = now;
+#endif
+	if ((wg_bits & 0x07) == 0)
+		wg_buf[wg_bits >> 3] = 0;
+	if (bit)
+		wg_buf[wg_bits >> 3] |= 0x80 >> (wg_bits & 0x07);
+	if (++wg_bits < WIEGAND_BITS)
+		return;
+
+	wg_bits = 0;
+	if (frame_begin(PINDEC_WIEGAND_ID, WIEGAND_LEN)) {
+		for (i = 0; i < WIEGAND_LEN; i++)
+			ring_put(wg_buf[i]);
+		event_put(EVT_PIN_FRAME, PINDEC_WIEGAND_ID | WIEGAND_LEN);
+	}
+}
+#endif
+
+#ifdef PINDEC_SHIFT
+#if (SHIFT_BITS & 7) || (SHIFT_BITS > 32)
+#error "SHIFT_BITS must be multiple of 8 up to 32"
+#endif
+#define SHIFT_LEN (SHIFT_BITS / 8)
+
+static __xdata uint8_t sh_buf[SHIFT_LEN];
+static uint8_t sh_bits;
+static uint8_t sh_byte;
+#if PINDEC_GAP
+static uint8_t sh_last;
+#endif
+
+/** shift clock rising edge, MSB first */
+static void shift_edge(void) __using(IRQ_PIN_REG_BANK)
+{
+	uint8_t i;
+
+#if PINDEC_GAP
+	if (sh_bits && gap(sh_last)) {
+		event_put(EVT_PIN_FRAME, PINDEC_SHIFT_ID | PINDEC_ERR | PINDEC_EGAP);
+		sh_bits = 0;
+	}
+	sh_last = now;
+#endif
+	sh_byte = (sh_byte << 1) | SHIFT_DAT;
+	if ((++sh_bits & 0x07) == 0)
+		sh_buf[(sh_bits >> 3) - 1] = sh_byte;
+	if (sh_bits < SHIFT_BITS)
+		return;
+
+	sh_bits = 0;
+	if (frame_begin(PINDEC_SHIFT_ID, SHIFT_LEN)) {
+		for (i = 0; i < SHIFT_LEN; i++)
+			ring_put(sh_buf[i]);
+		event_put(EVT_PIN_FRAME, PINDEC_SHIFT_ID | SHIFT_LEN);
+	}
+}
+#endif
+
+void pin_interrupt_handler(void) INTERRUPT(IRQ_PIN, IRQ_PIN_REG_BANK)
+{
+	uint8_t pif = PIF;
+
+	PROF_ENTER();
+	PIF &= ~pif; /* flags set meanwhile are kept for the next interrupt */
+#if PINDEC_GAP
+	now = wkt_ticks.milli8;
+#endif
+#ifdef PINDEC_PS2
+	if (pif & (1 << PS2_CLK_PIN))
+		ps2_edge();
+#endif
+#ifdef PINDEC_WIEGAND
+	if (pif & (1 << WIEGAND_D0_PIN))
+		wiegand_bit(0);
+	if (pif & (1 << WIEGAND_D1_PIN))
+		wiegand_bit(1);
+#endif
+#ifdef PINDEC_SHIFT
+	if (pif & (1 << SHIFT_CLK_PIN))
+		shift_edge();
+#endif
+#ifdef PINDEC_USER
+	pif &= ~(0
+#ifdef PINDEC_PS2
+		| (1 << PS2_CLK_PIN)
+#endif
+#ifdef PINDEC_WIEGAND
+		| (1 << WIEGAND_D0_PIN) | (1 << WIEGAND_D1_PIN)
+#endif
+#ifdef PINDEC_SHIFT
+		| (1 << SHIFT_CLK_PIN)
+#endif
+		);
+	if (pif)
+		pindec_user(pif);
+#endif
+	PROF_EXIT(PROF_PIN);
+}
+
+void pindec_init(void)
+{
+	pin_irq_init_port(PINDEC_PORT);
+#ifdef PINDEC_PS2
+	pin_irq_set_pin(PS2_CLK_PIN, PIN_IRQ_EDGE | PIN_IRQ_FALL);
+#endif
+#ifdef PINDEC_WIEGAND
+	pin_irq_set_pin(WIEGAND_D0_PIN, PIN_IRQ_EDGE | PIN_IRQ_FALL);
+	pin_irq_set_pin(WIEGAND_D1_PIN, PIN_IRQ_EDGE | PIN_IRQ_FALL);
+#endif
+#ifdef PINDEC_SHIFT
+	pin_irq_set_pin(SHIFT_CLK_PIN, PIN_IRQ_EDGE | PIN_IRQ_RISE);
+#endif
+}
+
+uint8_t pindec_get(void)
+{
+	uint8_t b;
+
+	if (ring_tail == ring_head)
+		return 0;
+	b = ring[ring_tail & (PINDEC_RING - 1)];
+	ring_tail++;
+	return b;
+}
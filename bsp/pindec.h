@@ -0,0 +1,104 @@
+/*
+  The MIT License (MIT)
+
+  Clock and data serial decoders on top of pin interrupt
+
+  Decoders run in pin_interrupt_handler(), received bits are assembled to
+  bytes, complete frames are copied to the __xdata ring and one
+  EVT_PIN_FRAME is posted per frame. Decoders are selected at compile time,
+  all of them share one pin interrupt port.
+
+  Configuration defines (can be changed in Makefile):
+	#define PINDEC_PORT 0    // pin interrupt port, PIN_IRQ_PORT0 - PIN_IRQ_PORT3
+	#define PINDEC_RING 32   // frames ring size in bytes, power of 2
+	#define PINDEC_GAP 10    // msec without clocks dropping a partial frame, 0 - never, uses tick.c
+	#define PINDEC_PS2       // PS/2 device, requires delay.c to send commands
+	#define PS2_CLK_PIN 4    //   clock pin index of the port, falling edge
+	#define PS2_CLK P04      //   clock pin
+	#define PS2_DAT P03      //   data pin
+	#define PINDEC_WIEGAND   // Wiegand reader, D0 and D1 falling edges
+	#define WIEGAND_D0_PIN 0 //   D0 pin index of the port
+	#define WIEGAND_D1_PIN 1 //   D1 pin index of the port
+	#define WIEGAND_BITS 26  //   bits per frame, up to 40
+	#define PINDEC_SHIFT     // synchronous shift register, MSB first
+	#define SHIFT_CLK_PIN 2  //   clock pin index of the port, rising edge
+	#define SHIFT_DAT P12    //   data pin
+	#define SHIFT_BITS 8     //   bits per frame, multiple of 8 up to 32
+	#define PINDEC_USER      // application pindec_user() gets other pins flags
+*/
+#ifndef N76E003_PINDEC_H
+#define N76E003_PINDEC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pinterrupt.h"
+#include "event.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef PINDEC_PORT
+#define PINDEC_PORT PIN_IRQ_PORT0
+#endif
+#ifndef PINDEC_RING
+#define PINDEC_RING 32
+#endif
+#ifndef PINDEC_GAP
+#define PINDEC_GAP 10
+#endif
+#ifndef WIEGAND_BITS
+#define WIEGAND_BITS 26
+#endif
+#ifndef SHIFT_BITS
+#define SHIFT_BITS 8
+#endif
+
+/**
+ * EVT_PIN_FRAME data: decoder in bits 7-6, PINDEC_ERR flag and
+ * frame length in bytes or error code in bits 4-0
+ */
+#define PINDEC_PS2_ID		0x00
+#define PINDEC_WIEGAND_ID	0x40
+#define PINDEC_SHIFT_ID		0x80
+#define PINDEC_ERR			0x20
+
+#define pindec_id(data)		((data) & 0xC0)
+#define pindec_len(data)	((data) & 0x1F)
+#define pindec_is_err(data)	((data) & PINDEC_ERR)
+
+/** error codes */
+enum pindec_err_t {
+	PINDEC_EPARITY,		/** PS/2 parity bit */
+	PINDEC_EACK,		/** PS/2 device did not ack the command */
+	PINDEC_ESTART,		/** PS/2 start bit */
+	PINDEC_ESTOP,		/** PS/2 stop bit */
+	PINDEC_EOVERFLOW,	/** no room for the frame in the ring */
+	PINDEC_EGAP			/** partial frame dropped after PINDEC_GAP */
+};
+
+/** configures pin interrupt port and pins of the enabled decoders */
+void pindec_init(void);
+
+/** next byte of the received frames, call pindec_len() times per event */
+uint8_t pindec_get(void);
+
+#ifdef PINDEC_PS2
+/** send a command or data byte to PS/2 device */
+void pindec_ps2_send(uint8_t cmd);
+
+/** true from pindec_ps2_send() until the device replies or an error */
+bool pindec_ps2_pending(void);
+#endif
+
+#ifdef PINDEC_USER
+/** application handler of the pins not used by decoders, pif - PIF flags */
+void pindec_user(uint8_t pif) __using(IRQ_PIN_REG_BANK);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
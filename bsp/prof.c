@@ -0,0 +1,73 @@
+/*
+  The MIT License (MIT)
+
+  Execution time profiling with Timer 2 running at Fsys
+
+  Configuration defines (can be changed in Makefile):
+    #define USE_PROF // compile PROF_ENTER()/PROF_EXIT() and "prof" command
+*/
+#include <N76E003.h>
+
+#include "irq.h"
+#include "uart.h"
+#include "prof.h"
+
+__xdata prof_t prof_stat[PROF_NUM];
+
+static const __code char prof_names[PROF_NUM][5] = {
+	"uart", "tick", "i2c ", "pwm ", "pin ", "spi ", "main"
+};
+
+void prof_init(void)
+{
+	clr_TR2;
+	T2MOD = 0;	/* pre-scale 1/1, no reload on compare */
+	T2CON = 0;	/* auto-reload mode, reload value RCMP2 */
+	RCMP2H = 0;
+	RCMP2L = 0;
+	TH2 = 0;
+	TL2 = 0;
+	prof_reset();
+	set_TR2;
+}
+
+void prof_reset(void)
+{
+	uint8_t i;
+
+	for (i = 0; i < PROF_NUM; i++) {
+		cli();
+		prof_stat[i].num = 0;
+		prof_stat[i].max = 0;
+		prof_stat[i].sum = 0;
+		sti();
+	}
+}
+
+void prof_print(void)
+{
+	prof_t stat;
+	uint8_t i;
+
+	uart_putsc("name count   min   max   avg\n");
+	for (i = 0; i < PROF_NUM; i++) {
+		cli();
+		stat.num = prof_stat[i].num;
+		stat.min = prof_stat[i].min;
+		stat.max = prof_stat[i].max;
+		stat.sum = prof_stat[i].sum;
+		sti();
+		if (stat.num == 0)
+			continue;
+		uart_putsc(prof_names[i]);
+		uart_putc(' ');
+		uart_putrn(stat.num);
+		uart_putc(' ');
+		uart_putrn(stat.min);
+		uart_putc(' ');
+		uart_putrn(stat.max);
+		uart_putc(' ');
+		uart_putrn((uint16_t)(stat.sum / stat.num));
+		uart_putc('\n');
+	}
+}
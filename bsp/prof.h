@@ -0,0 +1,93 @@
+/*
+  The MIT License (MIT)
+
+  Execution time profiling with Timer 2 running at Fsys
+
+  Configuration defines (can be changed in Makefile):
+    #define USE_PROF // compile PROF_ENTER()/PROF_EXIT() and "prof" command
+*/
+#ifndef N76E003_PROF_H
+#define N76E003_PROF_H
+
+#include <N76E003.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** profiled code sections */
+enum PROF_ID {
+	PROF_UART,	/** uart_interrupt_handler */
+	PROF_TICK,	/** tick_interrupt_handler */
+	PROF_I2C,	/** i2c_interrupt_handler */
+	PROF_PWM,	/** PWM interrupt handler */
+	PROF_PIN,	/** pin interrupt handler */
+	PROF_SPI,	/** spi_interrupt_handler */
+	PROF_MAIN,	/** main loop pass handling an event */
+	PROF_NUM
+};
+
+typedef struct {
+	uint16_t min;	/** Fsys clocks */
+	uint16_t max;
+	uint32_t sum;	/** for average value */
+	uint16_t num;	/** number of samples, halved with sum at 0xFFFF */
+} prof_t;
+
+extern __xdata prof_t prof_stat[PROF_NUM];
+
+#ifdef USE_PROF
+
+/** read free running Timer 2 counter to val16_t */
+#define prof_ts(ts) do { \
+	uint8_t _th; \
+	do { \
+		_th = TH2; \
+		(ts).u8low = TL2; \
+	} while (_th != TH2); \
+	(ts).u8high = _th; \
+} while (0)
+
+/** start measurement, must be placed before PROF_EXIT() in the same block */
+#define PROF_ENTER() val16_t prof_t0; prof_ts(prof_t0)
+
+/**
+ * add clocks passed since PROF_ENTER() to section statistics, up to 4 msec,
+ * saturated num and sum are halved to keep the average and min/max running
+ */
+#define PROF_EXIT(id) do { \
+	val16_t _t1; \
+	__xdata prof_t *_p = prof_stat + (id); \
+	prof_ts(_t1); \
+	_t1.u16 -= prof_t0.u16; \
+	if (_p->num == 0xFFFF) { \
+		_p->num >>= 1; \
+		_p->sum >>= 1; \
+	} \
+	if (_p->num == 0 || _t1.u16 < _p->min) \
+		_p->min = _t1.u16; \
+	if (_t1.u16 > _p->max) \
+		_p->max = _t1.u16; \
+	_p->sum += _t1.u16; \
+	_p->num++; \
+} while (0)
+
+#else
+#define PROF_ENTER()
+#define PROF_EXIT(id)
+#endif
+
+/** start Timer 2 in free running mode at Fsys, Timer 2 can not be used by the application */
+void prof_init(void);
+
+/** clear all statistics */
+void prof_reset(void);
+
+/** print statistics table: section, samples, min, max and average clocks */
+void prof_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
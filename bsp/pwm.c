@@ -3,6 +3,10 @@
 
   Simple routines to manipulate N76E003 PWM configuration.
   Not all available PWM features are enabled.
+
+  Configuration defines (can be changed in Makefile):
+	#define PWM_SHADOW // staged period/duty committed without waiting for LOAD
+	#define PWM_SEQ // table driven PMD/duty sequencer stepped from PWM interrupt
 */
 #include "pwm.h"
 
@@ -166,3 +170,151 @@ void pwm_irq_set_type(enum pwm_irq_type_t type)
 	PWMINTC |= type;
 	sfr_page(0);
 }
+
+#ifdef PWM_SHADOW
+#define SHADOW_PERIOD SET_BIT7 /** shadow_mask bit of the period */
+
+static __xdata uint16_t shadow_duty[PWM_NUM_CHANNELS];
+static __xdata uint16_t shadow_period;
+static uint8_t shadow_mask; /** staged channels and SHADOW_PERIOD */
+
+void pwm_shadow_period(uint16_t period)
+{
+	shadow_period = period;
+	shadow_mask |= SHADOW_PERIOD;
+}
+
+void pwm_shadow_duty(uint8_t channel, uint16_t duty)
+{
+	if (channel < PWM_NUM_CHANNELS) {
+		shadow_duty[channel] = duty;
+		shadow_mask |= 1 << channel;
+	}
+}
+
+bool pwm_shadow_commit(void)
+{
+	uint8_t i;
+
+	if (shadow_mask == 0)
+		return true;
+	/* registers must not change until LOAD is cleared at the period end */
+	if (PWMRUN && LOAD)
+		return false;
+
+	if (shadow_mask & SHADOW_PERIOD)
+		pwm_period_set(shadow_period);
+	for (i = 0; i < PWM_NUM_CHANNELS; i++) {
+		if (shadow_mask & (1 << i))
+			pwm_duty_set(i, shadow_duty[i]);
+	}
+	shadow_mask = 0;
+	LOAD = 1;
+	return true;
+}
+#endif
+
+#ifdef PWM_SEQ
+/* copy of the played table, read from the interrupt handler */
+static __xdata pwm_seq_t seq;
+static const pwm_seq_t *seq_next;	/** queued table */
+static const pwm_seq_t *seq_cur;	/** played table */
+static __xdata uint8_t seq_len;		/** values per duty set */
+static uint8_t seq_idx;
+static uint8_t seq_left;			/** interrupts left in the step */
+static __bit seq_run;
+
+void pwm_seq_start(const pwm_seq_t *table)
+{
+	cli_pwm();
+	seq_next = table;
+	seq_left = 0; /* holding step, the table is loaded by the next interrupt */
+	seq_run = 1;
+	sti_pwm();
+}
+
+void pwm_seq_queue(const pwm_seq_t *table)
+{
+	uint8_t irq = EIE & EIE_EPWM;
+
+	cli_pwm();
+	seq_next = table;
+	EIE |= irq;
+}
+
+const pwm_seq_t *pwm_seq_playing(void)
+{
+	const pwm_seq_t *cur;
+	uint8_t irq = EIE & EIE_EPWM;
+
+	cli_pwm();
+	cur = seq_cur;
+	EIE |= irq;
+	return cur;
+}
+
+void pwm_seq_stop(void)
+{
+	seq_run = 0;
+}
+
+#define SEQ_DUTY_SET(n) \
+	if (mask & (1 << n)) { PWM##n##L = LOBYTE(*duty); PWM##n##H = HIBYTE(*duty); duty++; }
+
+void pwm_seq_step(void) __using(IRQ_PWM_REG_BANK)
+{
+	const pwm_step_t *step;
+	const uint16_t *duty;
+	uint8_t mask;
+
+	if (!seq_run)
+		return;
+	if (seq_left) {
+		if (--seq_left)
+			return;
+		seq_idx++;
+	} else if (seq_next == NULL) {
+		return; /* hold the step */
+	} else {
+		seq_idx = seq.num; /* leave the holding step for the queued table */
+	}
+
+	if (seq_idx >= seq.num) {
+		seq_idx = 0;
+		if (seq_next) {
+			/* swap to the queued table */
+			seq_cur = seq_next;
+			seq_next = NULL;
+			seq.steps = seq_cur->steps;
+			seq.duties = seq_cur->duties;
+			seq.num = seq_cur->num;
+			seq.channels = mask = seq_cur->channels;
+			for (seq_len = 0; mask; mask >>= 1)
+				seq_len += mask & 1;
+			if (seq.num == 0) {
+				seq_run = 0;
+				return;
+			}
+		}
+	}
+
+	step = &seq.steps[seq_idx];
+	seq_left = step->count;
+	if (step->duty != PWM_SEQ_KEEP) {
+		duty = &seq.duties[step->duty * seq_len];
+		mask = seq.channels;
+		SEQ_DUTY_SET(0);
+		SEQ_DUTY_SET(1);
+		SEQ_DUTY_SET(2);
+		SEQ_DUTY_SET(3);
+		if (mask & (SET_BIT4 | SET_BIT5)) {
+			sfr_page(1);
+			SEQ_DUTY_SET(4);
+			SEQ_DUTY_SET(5);
+			sfr_page(0);
+		}
+		LOAD = 1; /* duties are applied at the end of PWM period */
+	}
+	PMD = step->pmd;
+}
+#endif
@@ -3,6 +3,10 @@
 
   Simple routines to manipulate N76E003 PWM configuration.
   Not all available PWM features are enabled.
+
+  Configuration defines (can be changed in Makefile):
+	#define PWM_SHADOW // staged period/duty committed without waiting for LOAD
+	#define PWM_SEQ // table driven PMD/duty sequencer stepped from PWM interrupt
 */
 #ifndef N76E003_PWM_H
 #define N76E003_PWM_H
@@ -78,6 +82,64 @@ enum pwm_irq_select_t {
 
 void pwm_irq_set_type(enum pwm_irq_type_t type);
 
+#ifdef PWM_SHADOW
+/**
+ * shadow registers: values are staged by pwm_shadow_period() and
+ * pwm_shadow_duty() and written to PWM registers with one LOAD by
+ * pwm_shadow_commit() once the hardware has applied the previous LOAD
+ */
+void pwm_shadow_period(uint16_t period);
+void pwm_shadow_duty(uint8_t channel, uint16_t duty);
+
+/**
+ * does not wait for the end of PWM period, call it from the main loop
+ * until nothing is pending. Staging and commit are not protected from
+ * interrupts, so all shadow calls must be made from the main loop only
+ * @return true if all staged values are loaded
+ */
+bool pwm_shadow_commit(void);
+#endif
+
+#ifdef PWM_SEQ
+#include <stddef.h>
+
+#include "irq.h"
+
+#define PWM_SEQ_KEEP 0xFF /** pwm_step_t::duty value to keep duty registers */
+
+/** sequencer step, applied at the PWM interrupt */
+typedef struct {
+	uint8_t pmd;	/** PMD (PWM Mask Data) of channels masked by PMEN */
+	uint8_t duty;	/** index of the duty set or PWM_SEQ_KEEP */
+	uint8_t count;	/** PWM interrupts to stay, 0 holds the step until a table is queued */
+} pwm_step_t;
+
+/** steps table, repeated until the next table is queued */
+typedef struct {
+	const pwm_step_t *steps;	/** __code or __xdata steps */
+	const uint16_t *duties;		/** __code or __xdata duty sets */
+	uint8_t num;				/** number of steps */
+	uint8_t channels;			/** mask of channels, one value per channel in a duty set */
+} pwm_seq_t;
+
+/** enables PWM interrupt, the first step is applied by the next interrupt */
+void pwm_seq_start(const pwm_seq_t *seq);
+
+/**
+ * the table replaces the running one after its last step, or at once
+ * from a holding step, NULL cancels the queued table
+ */
+void pwm_seq_queue(const pwm_seq_t *seq);
+
+/** currently played table, the queued one is not played yet */
+const pwm_seq_t *pwm_seq_playing(void);
+
+void pwm_seq_stop(void);
+
+/** call from pwm_interrupt_handler() once per interrupt */
+void pwm_seq_step(void) __using(IRQ_PWM_REG_BANK);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,109 @@
+/*
+  The MIT License (MIT)
+
+  PWM duty ramps (fades) stepped by WKT tick interrupt
+
+  Configuration defines (can be changed in Makefile):
+    #define USE_PWM_RAMP  // must be defined to call pwm_ramp_tick() from tick.c
+*/
+#include <N76E003.h>
+
+#include "pwm_ramp.h"
+#include "event.h"
+/* generated by pys/ramp-table.py into the sample folder */
+#include "pwm_ramp_tab.h"
+
+static __xdata uint16_t ramp_duty[PWM_RAMP_POINTS];
+static __xdata uint16_t ramp_interval;	/* msec per point */
+static uint16_t ramp_cnt;				/* msec to the next point */
+static uint8_t ramp_pos;				/* next point */
+static uint8_t ramp_channel;
+static volatile __bit ramp_run;
+
+/** span * k / 255 rounded */
+static uint16_t ramp_scale(uint16_t span, uint8_t k)
+{
+	return (uint16_t)(((uint32_t)span * k + 127) / 255);
+}
+
+void pwm_ramp_start(uint8_t channel, uint16_t target, uint16_t msec, uint8_t curve)
+{
+	__code const uint8_t *tab = ramp_tab[curve];
+	uint16_t from;
+	uint8_t i, k;
+
+	ramp_run = 0; /* the interrupt does not touch the ramp below */
+	from = pwm_duty_get(channel);
+	for (i = 0; i < PWM_RAMP_POINTS; i++) {
+		if (target >= from) {
+			ramp_duty[i] = from + ramp_scale(target - from, tab[i]);
+		} else {
+			/* backwards: the curve at (PWM_RAMP_POINTS - 1 - i) / PWM_RAMP_POINTS */
+			k = (i == PWM_RAMP_POINTS - 1) ? 0 : tab[PWM_RAMP_POINTS - 2 - i];
+			ramp_duty[i] = target + ramp_scale(from - target, k);
+		}
+	}
+
+	ramp_interval = msec / PWM_RAMP_POINTS;
+	if (ramp_interval == 0)
+		ramp_interval = 1;
+	ramp_cnt = ramp_interval;
+	ramp_channel = channel;
+	ramp_pos = 0;
+	ramp_run = 1;
+}
+
+void pwm_ramp_stop(void)
+{
+	ramp_run = 0;
+}
+
+bool pwm_ramp_busy(void)
+{
+	return ramp_run;
+}
+
+void pwm_ramp_tick(void) __using(IRQ_TICK_REG_BANK)
+{
+	uint16_t duty;
+
+	if (!ramp_run || --ramp_cnt)
+		return;
+	ramp_cnt = ramp_interval;
+	duty = ramp_duty[ramp_pos];
+	switch (ramp_channel) {
+	case 0:
+		PWM0L = LOBYTE(duty);
+		PWM0H = HIBYTE(duty);
+		break;
+	case 1:
+		PWM1L = LOBYTE(duty);
+		PWM1H = HIBYTE(duty);
+		break;
+	case 2:
+		PWM2L = LOBYTE(duty);
+		PWM2H = HIBYTE(duty);
+		break;
+	case 3:
+		PWM3L = LOBYTE(duty);
+		PWM3H = HIBYTE(duty);
+		break;
+	case 4:
+		sfr_page(1);
+		PWM4L = LOBYTE(duty);
+		PWM4H = HIBYTE(duty);
+		sfr_page(0);
+		break;
+	case 5:
+		sfr_page(1);
+		PWM5L = LOBYTE(duty);
+		PWM5H = HIBYTE(duty);
+		sfr_page(0);
+		break;
+	}
+	LOAD = 1; /* PWM period is expected to be shorter than the ramp interval */
+	if (++ramp_pos == PWM_RAMP_POINTS) {
+		ramp_run = 0;
+		event_put(EVT_PWM_RAMP, ramp_channel);
+	}
+}
@@ -0,0 +1,54 @@
+/*
+  The MIT License (MIT)
+
+  PWM duty ramps (fades) stepped by WKT tick interrupt
+
+  Duty values of the ramp are computed by pwm_ramp_start() from __code
+  curve tables generated by pys/ramp-table.py, the interrupt only writes
+  the next value, so the CPU can idle or sleep in idle mode during a fade.
+  One ramp runs at a time.
+
+  Configuration defines (can be changed in Makefile):
+    #define USE_PWM_RAMP  // must be defined to call pwm_ramp_tick() from tick.c
+*/
+#ifndef N76E003_PWM_RAMP_H
+#define N76E003_PWM_RAMP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pwm.h"
+#include "tick.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum pwm_ramp_curve_t {
+	PWM_RAMP_LINEAR,
+	PWM_RAMP_GAMMA,	/** linear perceived LED brightness */
+	PWM_RAMP_EXP
+};
+
+/**
+ * ramp channel duty from the current PWM#L/PWM#H value to the target,
+ * falling ramps play the curve backwards, so a fade out mirrors the fade in,
+ * EVT_PWM_RAMP with the channel is posted when the target is loaded
+ * @param msec duration, at least PWM_RAMP_POINTS msec
+ * @param curve one of pwm_ramp_curve_t
+ */
+void pwm_ramp_start(uint8_t channel, uint16_t target, uint16_t msec, uint8_t curve);
+
+/** stops at the current duty */
+void pwm_ramp_stop(void);
+
+bool pwm_ramp_busy(void);
+
+/** called by tick_interrupt_handler() every msec */
+void pwm_ramp_tick(void) __using(IRQ_TICK_REG_BANK);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
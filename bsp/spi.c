@@ -0,0 +1,353 @@
+/*
+  The MIT License (MIT)
+
+  SPI master block transfers and slave rings for N76E003,
+  see spi.h for configuration defines.
+
+  spi_write_x()/spi_write_i() loops are written in assembler to keep
+  the buffer pointer in DPTR/R0 and the counter in B, sdcc C loop
+  reloads them on every byte. __naked functions are called without
+  saving registers, so R0 is kept in DPH and restored.
+  Below 8 MHz SPCLK the loop polls SPSR_TXBUF, 21 clocks per byte
+  (N76E003 datasheet clocks): mov a,direct 3, jb 5, movx 4 (mov a,@r0 2),
+  mov direct,a 3, inc dptr 1 (inc r0 2), djnz direct 5.
+  At 8 MHz a byte takes 16 clocks plus 1 clock of SPIS 0 interval,
+  the poll is dropped and the loop is padded with nops to 17 clocks,
+  so the buffer is refilled right after the byte moves to the shifter.
+  An interrupt only delays the next write, but a faster loop would
+  overwrite the buffer, so 8 MHz needs SPIS 0 (reset value).
+  The datasheet clocks are not verified, s51 has no SPI and counts
+  classic 8051 cycles only.
+*/
+#include <N76E003.h>
+
+#include "spi.h"
+#include "prof.h"
+#if defined SPI_IRQ || defined SPI_SLAVE
+#include "event.h"
+#endif
+#ifdef SPI_SLAVE
+#include "pinterrupt.h"
+
+#if (SPI_RX_RING & (SPI_RX_RING - 1)) || (SPI_RX_RING > 128)
+#error "SPI_RX_RING must be power of 2 up to 128"
+#endif
+#if (SPI_TX_RING & (SPI_TX_RING - 1)) || (SPI_TX_RING > 128)
+#error "SPI_TX_RING must be power of 2 up to 128"
+#endif
+#endif
+
+static __bit spi_pending; /* the last written byte may be still shifting */
+
+/* SPIF and error flags to clear, DISMODF is kept */
+#define SPSR_FLAGS (SPSR_SPIF | SPSR_WCOL | SPSR_SPIOVF | SPSR_MODF)
+
+void spi_init(uint8_t mode)
+{
+	P10_PushPull_Mode; /* SPCLK */
+	P00_PushPull_Mode; /* MOSI */
+	SPSR = SPSR_DISMODF; /* SS as general I/O, no mode fault */
+	SPCR = (mode & (SPCR_SRR | SPCR_CPOL | SPCR_CPHA | SPCR_LSBFE)) | SPCR_MSTR | SPCR_SPIEN;
+	spi_pending = 0;
+}
+
+void spi_stop(void)
+{
+	spi_wait();
+	SPCR &= ~SPCR_SPIEN;
+}
+
+void spi_wait(void)
+{
+	if (spi_pending) {
+		while (!(SPSR & SPSR_SPIF));
+		SPSR &= ~SPSR_FLAGS;
+		spi_pending = 0;
+	}
+}
+
+uint8_t spi_xfer(uint8_t b)
+{
+	spi_wait();
+	SPDR = b;
+	while (!(SPSR & SPSR_SPIF));
+	SPSR &= ~SPSR_FLAGS;
+	return SPDR;
+}
+
+void spi_read_x(__xdata uint8_t *buf, uint8_t len)
+{
+	spi_wait();
+	while (len--) {
+		SPDR = 0xFF;
+		while (!(SPSR & SPSR_SPIF));
+		SPSR &= ~SPSR_FLAGS;
+		*buf++ = SPDR;
+	}
+}
+
+/**
+ * SPSR_TXBUF is cleared when the buffered byte moves to the shifter,
+ * SPIF of the byte before it is already set at this moment, so flags
+ * are cleared after the last byte leaves the buffer and spi_wait()
+ * gets SPIF of the last byte only
+ */
+void spi_write_x(__xdata const uint8_t *buf, uint8_t len) __naked
+{
+	buf; /* passed in dptr */
+	len; /* passed in _spi_write_x_PARM_2 */
+	__asm
+	mov	a,_spi_write_x_PARM_2
+	jz	00003$
+	mov	b,a
+	mov	a,_SPCR
+	anl	a,#0x03			; SPCR_SRR, 0 for 8 MHz SPCLK
+	jnz	00001$
+00004$:
+	movx	a,@dptr		; 4
+	mov	_SPDR,a			; 3
+	inc	dptr			; 1
+	nop					; 4 x 1
+	nop
+	nop
+	nop
+	djnz	b,00004$	; 5, 17 clocks per byte
+	sjmp	00002$
+00001$:
+	mov	a,_SPSR
+	jb	acc.2,00001$	; SPSR_TXBUF, wait for room in the buffer
+	movx	a,@dptr
+	mov	_SPDR,a
+	inc	dptr
+	djnz	b,00001$
+00002$:
+	mov	a,_SPSR
+	jb	acc.2,00002$
+	anl	_SPSR,#0x0F		; ~SPSR_FLAGS
+	setb	_spi_pending
+00003$:
+	ret
+	__endasm;
+}
+
+void spi_write_i(__idata const uint8_t *buf, uint8_t len) __naked
+{
+	buf; /* passed in dpl */
+	len; /* passed in _spi_write_i_PARM_2 */
+	__asm
+	mov	a,_spi_write_i_PARM_2
+	jz	00003$
+	mov	b,a
+	mov	dph,r0			; caller r0 is restored below
+	mov	r0,dpl
+	mov	a,_SPCR
+	anl	a,#0x03			; SPCR_SRR, 0 for 8 MHz SPCLK
+	jnz	00001$
+00004$:
+	mov	a,@r0			; 2
+	mov	_SPDR,a			; 3
+	inc	r0				; 2
+	nop					; 5 x 1
+	nop
+	nop
+	nop
+	nop
+	djnz	b,00004$	; 5, 17 clocks per byte
+	sjmp	00002$
+00001$:
+	mov	a,_SPSR
+	jb	acc.2,00001$	; SPSR_TXBUF, wait for room in the buffer
+	mov	a,@r0
+	mov	_SPDR,a
+	inc	r0
+	djnz	b,00001$
+00002$:
+	mov	a,_SPSR
+	jb	acc.2,00002$
+	anl	_SPSR,#0x0F		; ~SPSR_FLAGS
+	setb	_spi_pending
+	mov	r0,dph
+00003$:
+	ret
+	__endasm;
+}
+
+#ifdef SPI_IRQ
+static __xdata const uint8_t *irq_tx;
+static __xdata uint8_t *irq_rx;
+static volatile uint8_t irq_len; /* bytes left including the shifting one */
+static uint8_t irq_tag;
+
+bool spi_submit(__xdata const uint8_t *tx, __xdata uint8_t *rx, uint8_t len, uint8_t tag)
+{
+	if (irq_len)
+		return false;
+	if (len == 0)
+		return true;
+	spi_wait();
+	irq_tx = tx;
+	irq_rx = rx;
+	irq_len = len;
+	irq_tag = tag;
+	SPSR &= ~SPSR_FLAGS;
+	sti_spi();
+	/* the first byte, the rest are sent by the interrupt */
+	if (tx) {
+		SPDR = *tx;
+		irq_tx++;
+	} else
+		SPDR = 0xFF;
+	return true;
+}
+
+bool spi_busy(void)
+{
+	return irq_len;
+}
+#endif
+
+#ifdef SPI_SLAVE
+static __xdata uint8_t rx_ring[SPI_RX_RING];
+static volatile uint8_t rx_head;	/* written by the interrupt */
+static uint8_t rx_tail;				/* read by spi_slave_get() */
+static uint8_t rx_frame;			/* bytes of the current frame */
+static uint8_t rx_dropped;
+
+static __xdata uint8_t tx_ring[SPI_TX_RING];
+static uint8_t tx_head;				/* written by spi_slave_put() */
+static volatile uint8_t tx_tail;	/* moved by the interrupt */
+static volatile __bit tx_loaded;	/* tx_ring[tx_tail] is in SPDR */
+
+void spi_slave_init(uint8_t mode)
+{
+	cli_spi();
+	/* do not drive the master lines, spi_init() left SPCLK and MOSI push-pull */
+	P10_Input_Mode; /* SPCLK */
+	P00_Input_Mode; /* MOSI */
+	P15_Input_Mode; /* SS */
+	P01_PushPull_Mode; /* MISO, the only slave on the bus */
+	rx_head = rx_tail = rx_frame = rx_dropped = 0;
+	tx_head = tx_tail = 0;
+	tx_loaded = 0;
+	SPSR = 0; /* SS selects the slave, mode fault is reported */
+	SPCR = (mode & (SPCR_CPOL | SPCR_CPHA | SPCR_LSBFE)) | SPCR_SPIEN;
+	SPDR = 0xFF;
+	pin_irq_init_port(PIN_IRQ_PORT1);
+	pin_irq_set_pin(5, PIN_IRQ_EDGE | PIN_IRQ_RISE);
+	sti_spi();
+}
+
+/** store the received byte and load the next one to send */
+static void slave_byte(void) __using(IRQ_SPI_REG_BANK)
+{
+	uint8_t b = SPDR;
+
+	SPSR &= ~SPSR_FLAGS;
+	if (tx_loaded)
+		tx_tail++; /* the loaded byte is sent */
+	if (tx_tail != tx_head) {
+		SPDR = tx_ring[tx_tail & (SPI_TX_RING - 1)];
+		tx_loaded = 1;
+	} else {
+		SPDR = 0xFF;
+		tx_loaded = 0;
+	}
+	if ((uint8_t)(rx_head - rx_tail) == SPI_RX_RING) {
+		if (rx_dropped != 0xFF)
+			rx_dropped++;
+		return;
+	}
+	rx_ring[rx_head & (SPI_RX_RING - 1)] = b;
+	rx_head++;
+	rx_frame++;
+}
+
+void spi_slave_ss(void) __using(IRQ_PIN_REG_BANK)
+{
+	/* pin interrupt has higher priority, the last byte can be still pending */
+	if (SPSR & SPSR_SPIF)
+		slave_byte();
+	SPSR &= ~SPSR_FLAGS; /* mode fault of a partial byte */
+	if (rx_frame) {
+		event_put(EVT_SPI_FRAME, rx_frame);
+		rx_frame = 0;
+	}
+	/* the first byte of the next frame put after the last SPI interrupt */
+	if (!tx_loaded && tx_tail != tx_head) {
+		SPDR = tx_ring[tx_tail & (SPI_TX_RING - 1)];
+		tx_loaded = 1;
+	}
+}
+
+uint8_t spi_slave_get(void)
+{
+	uint8_t b;
+
+	if (rx_tail == rx_head)
+		return 0;
+	b = rx_ring[rx_tail & (SPI_RX_RING - 1)];
+	rx_tail++;
+	return b;
+}
+
+bool spi_slave_put(uint8_t b)
+{
+	if ((uint8_t)(tx_head - tx_tail) == SPI_TX_RING)
+		return false;
+	tx_ring[tx_head & (SPI_TX_RING - 1)] = b;
+	tx_head++;
+	cli();
+	/* SS is high, the byte goes first in the next frame */
+	if (!tx_loaded && P15) {
+		SPDR = tx_ring[tx_tail & (SPI_TX_RING - 1)];
+		/* SS fell after the check, the write is ignored during the transfer
+		   and the byte is loaded by the SPI interrupt at the end of it */
+		if (SPSR & SPSR_WCOL)
+			SPSR &= ~SPSR_WCOL;
+		else
+			tx_loaded = 1;
+	}
+	sti();
+	return true;
+}
+
+uint8_t spi_slave_dropped(void)
+{
+	return rx_dropped;
+}
+#endif
+
+#if defined SPI_IRQ || defined SPI_SLAVE
+void spi_interrupt_handler(void) INTERRUPT(IRQ_SPI, IRQ_SPI_REG_BANK)
+{
+	PROF_ENTER();
+#ifdef SPI_SLAVE
+	if (!(SPCR & SPCR_MSTR)) {
+		slave_byte();
+		PROF_EXIT(PROF_SPI);
+		return;
+	}
+#endif
+#ifdef SPI_IRQ
+	uint8_t b = SPDR;
+
+	SPSR &= ~SPSR_FLAGS;
+	if (--irq_len) {
+		/* start the next byte first, then store the received one */
+		if (irq_tx) {
+			SPDR = *irq_tx;
+			irq_tx++;
+		} else
+			SPDR = 0xFF;
+	} else {
+		cli_spi();
+		event_put(EVT_SPI, irq_tag);
+	}
+	if (irq_rx) {
+		*irq_rx = b;
+		irq_rx++;
+	}
+#endif
+	PROF_EXIT(PROF_SPI);
+}
+#endif
@@ -0,0 +1,131 @@
+/*
+  The MIT License (MIT)
+
+  SPI master block transfers and slave receive/transmit rings for N76E003
+
+  Blocking calls poll SPSR, spi_write_x()/spi_write_i() keep the next byte
+  in the transmit buffer while the current one is shifting (SPSR_TXBUF).
+  At 8 MHz SPCLK the poll is replaced by a loop of 17 clocks per byte,
+  the byte time with SPIS 0, so SPIS must be left 0 for 8 MHz writes,
+  lower clocks poll SPSR_TXBUF with any SPIS. Interrupt driven transfers
+  run one byte per SPI interrupt and post EVT_SPI when the block is done.
+  SS is a general I/O, slave select pins are driven by the application.
+
+  In slave mode SPI interrupt stores received bytes to the __xdata ring
+  and loads the next byte to send from the transmit ring. The end of
+  a frame is SS (P1.5) rising edge, the application pin interrupt handler
+  calls spi_slave_ss() and one EVT_SPI_FRAME is posted per frame.
+  SPI interrupt takes a few usec, so the master must keep bytes apart,
+  1 MHz SPCLK with 2 usec between bytes is safe.
+
+  Configuration defines (can be changed in Makefile):
+    #define SPI_IRQ // compile spi_submit() and SPI interrupt handler
+    #define SPI_SLAVE // compile slave mode and SPI interrupt handler
+    #define SPI_RX_RING 64 // slave receive ring size, power of 2 up to 128
+    #define SPI_TX_RING 16 // slave transmit ring size, power of 2 up to 128
+*/
+#ifndef N76E003_SPI_H
+#define N76E003_SPI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "irq.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * enable SPI master, SPCLK and MOSI are switched to push-pull
+ * @param mode SPI_CLOCK_xMHZ combined with SPCR_CPOL, SPCR_CPHA and SPCR_LSBFE
+ */
+void spi_init(uint8_t mode);
+
+/** disable SPI, pins are left as is */
+void spi_stop(void);
+
+/** send and receive one byte, waits for the end of the previous write */
+uint8_t spi_xfer(uint8_t b);
+
+/**
+ * pipelined write of 'len' bytes, received bytes are dropped,
+ * returns when the last byte starts shifting, use spi_wait() before
+ * changing SS or SPI settings
+ */
+void spi_write_x(__xdata const uint8_t *buf, uint8_t len) __naked;
+void spi_write_i(__idata const uint8_t *buf, uint8_t len) __naked;
+
+/** read 'len' bytes sending 0xFF */
+void spi_read_x(__xdata uint8_t *buf, uint8_t len);
+
+/** wait for the end of the last spi_write_x()/spi_write_i() byte */
+void spi_wait(void);
+
+#if defined SPI_IRQ || defined SPI_SLAVE
+void spi_interrupt_handler(void) INTERRUPT(IRQ_SPI, IRQ_SPI_REG_BANK);
+#endif
+
+#ifdef SPI_IRQ
+#include <stddef.h>
+
+/**
+ * start interrupt driven full duplex transfer, EVT_SPI with 'tag'
+ * is posted at the end, buffers must stay valid until the event.
+ * Blocking spi_* calls must not be used while spi_busy() returns true.
+ *
+ * @param tx bytes to send, NULL to send 0xFF
+ * @param rx buffer for received bytes, NULL to drop them
+ * @param len number of bytes, 1 to 255
+ * @param tag EVT_SPI event data
+ * @return false if a transfer is in progress
+ */
+bool spi_submit(__xdata const uint8_t *tx, __xdata uint8_t *rx, uint8_t len, uint8_t tag);
+
+/** true until the submitted transfer is done */
+bool spi_busy(void);
+#endif
+
+#ifdef SPI_SLAVE
+#ifndef SPI_RX_RING
+#define SPI_RX_RING 64
+#endif
+#ifndef SPI_TX_RING
+#define SPI_TX_RING 16
+#endif
+
+/**
+ * enable SPI slave with SS pin, configures pin interrupt on P1.5
+ * rising edge, the rest of port 1 pins can be set after this call.
+ * SPCLK, MOSI and SS are switched to input, MISO to push-pull,
+ * so the board must be the only slave on the bus
+ * @param mode SPCR_CPOL, SPCR_CPHA and SPCR_LSBFE, must match the master
+ */
+void spi_slave_init(uint8_t mode);
+
+/**
+ * SS rising edge, call from pin interrupt handler, posts EVT_SPI_FRAME
+ * with the number of frame bytes in the receive ring
+ */
+void spi_slave_ss(void) __using(IRQ_PIN_REG_BANK);
+
+/** next received byte, call EVT_SPI_FRAME data times per event */
+uint8_t spi_slave_get(void);
+
+/**
+ * queue a byte to send, bytes are sent in order across the frames,
+ * 0xFF is sent when the ring is empty. A reply put after EVT_SPI_FRAME
+ * starts with the first byte of the next frame
+ * @return false if the transmit ring is full
+ */
+bool spi_slave_put(uint8_t b);
+
+/** received bytes dropped on full receive ring, saturates at 255 */
+uint8_t spi_slave_dropped(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -5,11 +5,15 @@
 
   Configuration defines (can be changed in Makefile):
     #define CMD_LEN 0x20 // must be power of two
+    #define USE_PROF // add built-in "prof [reset]" command, see prof.h
 */
 #include <N76E003.h>
 
 #include "uart.h"
 #include "terminal.h"
+#ifdef USE_PROF
+#include "prof.h"
+#endif
 
 /* Escape sequence states */
 #define ESC_CHAR    0
@@ -146,6 +150,24 @@ static uint8_t  cursor;
 static __idata char cmd[CMD_LEN + 1];
 static __xdata char hist[CMD_LEN + 1];
 
+/** built-in commands first, then application parser */
+static int8_t cli_parse(__idata char *buf)
+{
+#ifdef USE_PROF
+	if (str_is(buf, "prof")) {
+		__idata char *arg = get_arg(buf);
+		if (*arg == '\0')
+			prof_print();
+		else if (str_is(arg, "reset"))
+			prof_reset();
+		else
+			return CLI_EARG;
+		return CLI_EOK;
+	}
+#endif
+	return parser(buf);
+}
+
 void cli_init(cli_processor *process)
 {
 	cursor = 0;
@@ -167,7 +189,7 @@ int8_t cli_exec(const __code char *str)
 			break;
 		}
 	}
-	ch = parser(cmd);
+	ch = cli_parse(cmd);
 	if (i)
 		uart_putsc("> ");
 	cmd[0] = '\0'; /* reset command buffer */
@@ -198,7 +220,7 @@ int8_t cli_interact(char c)
 		uart_putc(ch);
 		if (*cmd) {
 			cmd[cursor] = '\0';
-			int8_t ret = parser(cmd);
+			int8_t ret = cli_parse(cmd);
 			if (ret == CLI_EARG)
 				uart_putsc("Invalid argument\n");
 			else if (ret == CLI_ENOTSUP)
@@ -244,3 +266,18 @@ int8_t cli_interact(char c)
 
 	return 1;
 }
+
+#ifdef UART_RX_RING
+int8_t cli_interact_line(void)
+{
+	int8_t ret = 0;
+	val16_t ch;
+
+	for (ch.u16 = uart_getc(); ch.u8high & UART_DATA_VALID; ch.u16 = uart_getc()) {
+		if (ch.u8high & UART_ERR_OVERFLOW)
+			uart_putsc("RX overflow\n");
+		ret |= cli_interact(ch.u8low);
+	}
+	return ret;
+}
+#endif
@@ -5,6 +5,7 @@
 
   Configuration defines (can be changed in Makefile):
     #define CMD_LEN 0x20 // must be power of two
+    #define USE_PROF // add built-in "prof [reset]" command, see prof.h
 */
 #ifndef N76E003_TERMINAL_H
 #define N76E003_TERMINAL_H
@@ -35,6 +36,10 @@ typedef int8_t cli_processor(__idata char *buf);
 void cli_init(cli_processor *process);
 
 int8_t cli_interact(char ch);
+#ifdef UART_RX_RING
+/** feed all bytes from UART receive ring to cli_interact(), call on EVT_UART_LINE */
+int8_t cli_interact_line(void);
+#endif
 int8_t cli_exec(const __code char *cmd);
 
 /* helper functions */
@@ -5,30 +5,108 @@
 
   Configuration defines (can be changed in Makefile):
     #define TICK_DEBUG P12 // define pit to toggle on WKT interrupt
+    #define USE_TIMER_WHEEL // advance software timers, see timer.h
+    #define TICK_TICKLESS // sleep without 1 msec wake-ups in idle()/sleep()
+    #define USE_PWM_RAMP // step PWM ramps, see pwm_ramp.h
 */
 #include <N76E003.h>
 
 #include "tick.h"
 #include "event.h"
+#include "prof.h"
+#ifdef USE_TIMER_WHEEL
+#include "timer.h"
+#endif
+#ifdef USE_PWM_RAMP
+#include "pwm_ramp.h"
+#endif
 
 wkt_tick_t wkt_ticks;
 static uint8_t evt_counter;
 static uint8_t evt_interval;
 
+#ifdef TICK_TICKLESS
+/*
+ * WKT is never stopped, RWK is reloaded on overflow, so a new period is
+ * pipelined: RWK is written in the interrupt one period ahead and the
+ * pre-scale is switched in the interrupt at the start of the period.
+ * Requested period is used once, then WKT returns to 1 msec periods.
+ */
+static uint16_t tick_step = 1;	/* msec of the running WKT period */
+static uint16_t next_step = 1;	/* msec of the period loaded on overflow */
+static uint8_t tick_ps;			/* pre-scale of the running period */
+static uint8_t next_ps;
+static volatile uint16_t req_step;	/* requested period msec, 0 for 1 msec */
+static uint8_t req_ps;
+static uint8_t req_rwk;
+static uint16_t wake_counter;	/* WKT interrupts in the current second */
+static uint16_t wake_msec;		/* msec in the current second */
+static uint16_t wake_rate;		/* WKT interrupts in the last second */
+
+/**
+ * WKT pre-scales with integer number of msec per a few WKT clocks:
+ * 1/1 - 10 clocks per 1 msec, 1/4 - 5 clocks per 2 msec, 1/16 - 5 clocks per 8 msec...
+ */
+static const __code uint16_t wkt_unit[] = { 1, 2, 8, 32, 128, 256, 512, 1024 };
+#endif
+
 void tick_interrupt_handler(void) INTERRUPT(IRQ_TICK,IRQ_TICK_REG_BANK)
 {
+	PROF_ENTER();
+#ifdef TICK_TICKLESS
+	uint16_t step = tick_step;
+
+	/* the next period is already loaded from RWK, switch its pre-scale */
+	tick_step = next_step;
+	if (tick_ps != next_ps) {
+		tick_ps = next_ps;
+		WKCON = (WKCON & ~WKCON_WKPS) | tick_ps;
+	}
+	if (req_step) {
+		next_step = req_step;
+		next_ps = req_ps;
+		RWK = req_rwk;
+		req_step = 0;
+	} else if (next_step != 1) {
+		next_step = 1;
+		next_ps = 0;
+		RWK = (uint8_t)(255 - 10 + 1);
+	}
+
+	wkt_ticks.millis += step;
+	evt_counter += (uint8_t)step; /* step is limited by evt_interval */
+	wake_counter++;
+	wake_msec += step;
+	if (wake_msec >= 1000) {
+		wake_rate = wake_counter;
+		wake_counter = 0;
+		wake_msec = 0;
+	}
+#else
 	wkt_ticks.millis++;
 	evt_counter++;
+#endif
 
-	if (evt_interval && (evt_counter == evt_interval)) {
+	if (evt_interval && (evt_counter >= evt_interval)) {
 		evt_counter = 0;
-		event_put(EVT_TICK, evt_interval);
+		event_put(EVT_TICK, 1); /* coalesced events accumulate the count */
 	}
+#ifdef USE_TIMER_WHEEL
+#ifdef TICK_TICKLESS
+	timer_skip(step); /* step is limited by the nearest timer */
+#else
+	timer_tick();
+#endif
+#endif
+#ifdef USE_PWM_RAMP
+	pwm_ramp_tick(); /* tickless steps are 1 msec while a ramp runs */
+#endif
 
 #ifdef TICK_DEBUG
 	TICK_DEBUG ^= 1;
 #endif
 	WKCON &= ~WKCON_WKTF; /* clear WKT overflow interrupt flag */
+	PROF_EXIT(PROF_TICK);
 }
 
 void tick_init(uint8_t evt_timer)
@@ -53,9 +131,78 @@ uint8_t tick_interval(uint8_t evt_timer)
 	return ret;
 }
 
+#ifdef TICK_TICKLESS
+static void tickless_wait(uint16_t ticks, enum POWER_MODE mode)
+{
+	uint16_t start, msec, step, target;
+	uint8_t ps, k;
+
+	start = millis();
+	while (1) {
+		msec = millis();
+		if ((uint16_t)(msec - start) >= ticks)
+			return;
+		step = ticks - (uint16_t)(msec - start);
+#ifdef USE_TIMER_WHEEL
+		uint16_t next = timer_next();
+		if (next && step > next)
+			step = next;
+#endif
+#ifdef USE_PWM_RAMP
+		if (pwm_ramp_busy())
+			step = 1;
+#endif
+		cli();
+		if (wkt_ticks.milli16 != msec) { /* tick in between, limits are stale */
+			sti();
+			continue;
+		}
+		/* wake up in time for the next EVT_TICK */
+		if (evt_interval && step > (uint8_t)(evt_interval - evt_counter))
+			step = (uint8_t)(evt_interval - evt_counter);
+		/* requested period starts after the running and the loaded 1 msec ones */
+		target = msec - start + 1;
+		if (step > 3) {
+			step -= 2;
+			/* the largest pre-scale fitting the step, up to 255 WKT clocks per period */
+			for (ps = 7; ps && wkt_unit[ps] > step; ps--);
+			k = (ps ? 51 : 25);
+			if (step / wkt_unit[ps] < k)
+				k = step / wkt_unit[ps];
+			req_ps = ps;
+			req_rwk = (uint8_t)(256 - (ps ? 5 * k : 10 * k));
+			req_step = k * wkt_unit[ps];
+			target = msec - start + 2 + req_step;
+		}
+		sti();
+
+		/* other interrupts can wake up the CPU as well */
+		do {
+			PCON &= ~(PCON_PD | PCON_IDL);
+			PCON |= mode;
+		} while ((uint16_t)(millis() - start) < target);
+	}
+}
+
+uint16_t tick_wakeups(void)
+{
+	uint16_t rate;
+	cli();
+	rate = wake_rate;
+	sti();
+	return rate;
+}
+#endif
+
 void wait(uint16_t ticks, enum POWER_MODE mode)
 {
 	uint16_t start;
+#ifdef TICK_TICKLESS
+	if (ticks && mode != POWER_MODE_UP) {
+		tickless_wait(ticks, mode);
+		return;
+	}
+#endif
 	cli();
 	start = wkt_ticks.milli16;
 	sti();
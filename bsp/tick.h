@@ -5,6 +5,9 @@
 
   Configuration defines (can be changed in Makefile):
     #define TICK_DEBUG P12 // define pit to toggle on WKT interrupt
+    #define USE_TIMER_WHEEL // advance software timers, see timer.h
+    #define TICK_TICKLESS // sleep without 1 msec wake-ups in idle()/sleep()
+    #define USE_PWM_RAMP // step PWM ramps, see pwm_ramp.h
 */
 #ifndef N76E003_WKT_H
 #define N76E003_WKT_H
@@ -36,6 +39,7 @@ void tick_interrupt_handler(void) INTERRUPT(IRQ_TICK,IRQ_TICK_REG_BANK);
  * @brief initialize 'tick' timer interrupts for 1 msec timer
  *
  * @param evt_timer interval in msec to generate EVT_TICK. 0 to disable event.
+ *        EVT_TICK data is a number of passed intervals, see EVENT_COALESCE
  */
 void tick_init(uint8_t evt_timer);
 
@@ -56,11 +60,21 @@ enum POWER_MODE {
 /**
  * @brief wait for number of timer clocks
  *
+ * If TICK_TICKLESS is defined then idle and down modes request a long
+ * WKT period ending at the next EVT_TICK, software timer or the end of wait,
+ * millis counter is advanced by the slept time. WKT keeps running, the
+ * period is switched at tick boundaries and starts after two 1 msec ones.
+ *
  * @param ticks number of WKT ticks to wait
  * @param mode waiting mode, POWER_MODE_UP, POWER_MODE_IDLE, POWER_MODE_DOWN
  */
 void wait(uint16_t ticks, enum POWER_MODE mode);
 
+#ifdef TICK_TICKLESS
+/** number of WKT interrupts during the last second, 1000 without tickless waits */
+uint16_t tick_wakeups(void);
+#endif
+
 inline uint8_t millis8(void) { return wkt_ticks.milli8; }
 uint16_t millis(void);
 uint32_t millis32(void);
@@ -80,6 +94,7 @@ uint32_t millis32(void);
  *  50  ~51
  * 100  ~99
  * 250 ~245
+ * use delay_us() from delay.h for cycle exact constant delays
  */
 void delay_mks(uint16_t mks);
 
@@ -0,0 +1,176 @@
+/*
+  The MIT License (MIT)
+
+  Software timers wheel driven by WKT tick interrupt
+
+  Configuration defines (can be changed in Makefile):
+    #define USE_TIMER_WHEEL  // must be defined to call timer_tick() from tick.c
+    #define TIMER_NUM 8      // number of software timers
+    #define TIMER_SLOTS 8    // number of wheel slots, must be power of 2
+*/
+#include <N76E003.h>
+
+#include "tick.h"
+#include "event.h"
+#include "timer.h"
+
+#define TIMER_SLOT_MASK (TIMER_SLOTS - 1)
+#define TIMER_NIL 0	   /** end of slot list, zero-initialized memory is empty wheel */
+#define TIMER_ACTIVE 0x80 /** timer is in the wheel, low bits are the slot */
+
+typedef struct {
+	uint8_t next;	  /** next timer index + 1 in the same slot or TIMER_NIL */
+	uint8_t slot;	  /** TIMER_ACTIVE | slot index, 0 if not active */
+	uint16_t rounds;  /** full wheel turns left before expiration */
+	uint16_t period;  /** reload interval, 0 for one-shot */
+	uint8_t type;	  /** event type */
+	uint8_t data;	  /** event data */
+} sw_timer_t;
+
+static uint8_t wheel_pos;					/** current slot */
+static __idata uint8_t slot_head[TIMER_SLOTS];	/** first timer index + 1 in the slot */
+
+static __xdata sw_timer_t timers[TIMER_NUM];
+
+/**
+ * put timer to the slot of its expiration time, the slot at wheel_pos is
+ * reached after TIMER_SLOTS ticks, so delay is counted as (rounds, slot) pair.
+ * Macro is used as the code runs in both ISR and main register banks.
+ */
+#define wheel_insert(t, link, delay) do { \
+	uint8_t slot = (wheel_pos + (uint8_t)(delay)) & TIMER_SLOT_MASK; \
+	t->slot = TIMER_ACTIVE | slot; \
+	t->rounds = ((delay) - 1) / TIMER_SLOTS; \
+	t->next = slot_head[slot]; \
+	slot_head[slot] = link; \
+} while (0)
+
+#pragma save
+#pragma nooverlay
+
+void timer_tick(void) __using(IRQ_TICK_REG_BANK)
+{
+	__xdata sw_timer_t *t;
+	uint8_t prev = TIMER_NIL;
+	uint8_t fired = TIMER_NIL;
+	uint8_t id;
+
+	wheel_pos = (wheel_pos + 1) & TIMER_SLOT_MASK;
+	id = slot_head[wheel_pos];
+	while (id != TIMER_NIL) {
+		t = timers + id - 1;
+		uint8_t next = t->next;
+		if (t->rounds) {
+			t->rounds -= 1;
+			prev = id;
+		} else {
+			event_put(t->type, t->data);
+			/* unlink expired timer, periodic ones are collected to re-insert */
+			if (prev == TIMER_NIL)
+				slot_head[wheel_pos] = next;
+			else
+				timers[prev - 1].next = next;
+			t->slot = 0;
+			if (t->period) {
+				t->next = fired;
+				fired = id;
+			}
+		}
+		id = next;
+	}
+
+	while (fired != TIMER_NIL) {
+		id = fired;
+		t = timers + id - 1;
+		fired = t->next;
+		wheel_insert(t, id, t->period);
+	}
+}
+
+/**
+ * full wheel turns do not fire any timer, so they only decrement rounds,
+ * at most TIMER_SLOTS slots are walked regardless of msec
+ */
+void timer_skip(uint16_t msec) __using(IRQ_TICK_REG_BANK)
+{
+	__xdata sw_timer_t *t = timers;
+	uint16_t turns = (msec - 1) / TIMER_SLOTS;
+	uint8_t i;
+
+	if (turns) {
+		for (i = 0; i < TIMER_NUM; i++, t++) {
+			if (!t->slot)
+				continue;
+			/* timer started by an interrupt during the step fires late */
+			if (t->rounds > turns)
+				t->rounds -= turns;
+			else
+				t->rounds = 0;
+		}
+	}
+	for (i = (uint8_t)((msec - 1) & TIMER_SLOT_MASK) + 1; i; i--)
+		timer_tick();
+}
+
+#pragma restore
+
+void timer_stop(uint8_t id)
+{
+	__xdata sw_timer_t *t = timers + id;
+	uint8_t slot, i;
+
+	cli();
+	if (t->slot) {
+		/* find the timer in its slot list */
+		slot = t->slot & TIMER_SLOT_MASK;
+		i = slot_head[slot];
+		if (i == id + 1)
+			slot_head[slot] = t->next;
+		else {
+			while (timers[i - 1].next != id + 1)
+				i = timers[i - 1].next;
+			timers[i - 1].next = t->next;
+		}
+		t->slot = 0;
+	}
+	sti();
+}
+
+void timer_start(uint8_t id, uint16_t delay, uint16_t period, uint8_t type, uint8_t data)
+{
+	__xdata sw_timer_t *t = timers + id;
+
+	timer_stop(id);
+	if (delay == 0)
+		delay = 1;
+	t->period = period;
+	t->type = type;
+	t->data = data;
+	cli();
+	wheel_insert(t, id + 1, delay);
+	sti();
+}
+
+bool timer_active(uint8_t id)
+{
+	return timers[id].slot != 0;
+}
+
+uint16_t timer_next(void)
+{
+	__xdata sw_timer_t *t = timers;
+	uint16_t next = 0;
+	uint16_t msec;
+	uint8_t i;
+
+	cli();
+	for (i = 0; i < TIMER_NUM; i++, t++) {
+		if (!t->slot)
+			continue;
+		msec = ((t->slot - wheel_pos - 1) & TIMER_SLOT_MASK) + 1 + t->rounds * TIMER_SLOTS;
+		if (next == 0 || msec < next)
+			next = msec;
+	}
+	sti();
+	return next;
+}
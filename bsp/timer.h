@@ -0,0 +1,75 @@
+/*
+  The MIT License (MIT)
+
+  Software timers wheel driven by WKT tick interrupt
+
+  Configuration defines (can be changed in Makefile):
+    #define USE_TIMER_WHEEL  // must be defined to call timer_tick() from tick.c
+    #define TIMER_NUM 8      // number of software timers
+    #define TIMER_SLOTS 8    // number of wheel slots, must be power of 2
+*/
+#ifndef N76E003_TIMER_H
+#define N76E003_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tick.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** number of software timers, located in xdata */
+#ifndef TIMER_NUM
+#define TIMER_NUM 8
+#endif
+
+/**
+ * Timers are hashed into slots by expiration time, so the tick
+ * interrupt checks only timers of one slot per millisecond.
+ * Use number of slots close to TIMER_NUM, must be power of 2.
+ */
+#ifndef TIMER_SLOTS
+#define TIMER_SLOTS 8
+#endif
+
+/**
+ * advance the wheel by one millisecond, called by tick_interrupt_handler()
+ * if USE_TIMER_WHEEL is defined. The cost grows with timers linked in the
+ * current slot, 'timer' bench of pys/sim-s51.py reports it for 0, 1 and
+ * TIMER_NUM timers, the numbers are not recorded yet.
+ */
+void timer_tick(void) __using(IRQ_TICK_REG_BANK);
+
+/**
+ * advance the wheel by 'msec', called by tick_interrupt_handler() if
+ * TICK_TICKLESS is defined, no timer may expire before the last msec
+ */
+void timer_skip(uint16_t msec) __using(IRQ_TICK_REG_BANK);
+
+/**
+ * start or restart software timer
+ *
+ * @param id timer index 0 to TIMER_NUM-1
+ * @param delay msec to the first event, 0 is treated as 1
+ * @param period msec between the following events, 0 for one-shot timer
+ * @param type event type to generate on expiration
+ * @param data event data
+ */
+void timer_start(uint8_t id, uint16_t delay, uint16_t period, uint8_t type, uint8_t data);
+
+/** stop timer, pending event is not removed from the events buffer */
+void timer_stop(uint8_t id);
+
+/** true if timer is started and is not expired yet */
+bool timer_active(uint8_t id);
+
+/** msec to the nearest timer expiration or 0 if no timers are active */
+uint16_t timer_next(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
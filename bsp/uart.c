@@ -6,13 +6,17 @@
   Default defines (can be changed in Makefile):
 	#define USE_UART 0 // select UART port 0 or 1
 	#define FOSC_16600 // system clock set to 16.600 MHz
+	#define UART_RX_RING // receive to xdata ring instead of EVT_UART_RX per byte
+	#define SIM_S51 // UART0 clocked by Timer 1 for s51 simulator without Timer 3
 */
 #include <N76E003.h>
 
 #include "uart.h"
 #include "event.h"
+#include "prof.h"
 
 #define UART_BUF_MASK (UART_BUF_SIZE - 1)
+#define UART_DESC_MASK (UART_DESC_NUM - 1)
 
 static volatile uint8_t tx_idx;   /* ISR reads from this position */
 static volatile uint8_t tx_num;   /* number of bytes in the transmit buffer */
@@ -20,6 +24,31 @@ static volatile __bit   tx_empty; /* true if transmit buffer is empty */
 
 static __xdata uint8_t tx_buffer[UART_BUF_SIZE];
 
+typedef struct {
+	const uint8_t *buf; /* generic pointer to the next byte to send */
+	uint16_t len;		/* number of bytes left to send */
+	uint8_t before;		/* tx_buffer bytes to be sent before this block */
+	uint8_t tag;		/* EVT_UART_TX event data */
+} uart_desc_t;
+
+static volatile uint8_t desc_idx; /* descriptor being sent */
+static volatile uint8_t desc_num; /* number of queued descriptors */
+static uint8_t tx_tail; /* bytes put to tx_buffer after the last descriptor */
+
+static __xdata uart_desc_t tx_desc[UART_DESC_NUM];
+
+#ifdef UART_RX_RING
+#define UART_RX_MASK (UART_RX_SIZE - 1)
+
+static uint8_t rx_idx;			 /* uart_getc() reads from this position */
+static volatile uint8_t rx_num;	 /* number of bytes in the receive ring */
+static volatile uint8_t rx_err;	 /* UART_ERR_OVERFLOW if a byte was lost */
+static volatile __bit rx_line;	 /* EVT_UART_LINE posted, but ring not drained yet */
+static __bit rx_retry;			 /* EVT_UART_LINE was dropped */
+
+static __xdata uint8_t rx_buffer[UART_RX_SIZE];
+#endif
+
 #if defined FOSC_16600
 static const uint8_t br_reload[7][2] = {
 	// RHx  RLx        Value Baudrate Actual       Error %
@@ -71,6 +100,15 @@ void uart_init(enum UART_BR baudrate, bool rx_enable)
 	SCON = 0x40;  	/* UART0 Mode 1 */
 	/* Set SMOD to divide Timer 3 overflow rate by 16 - same as UART1 default */
 	set_SMOD;		/* UART0 Double Rate Enable */
+#ifdef SIM_S51
+	/* classic 8051 simulator has no Timer 3, so use Timer 1 auto-reload */
+	baudrate;
+	TMOD = (TMOD & 0x0F) | 0x20;
+	TH1 = 0xFF;
+	set_TR1;
+	if (rx_enable)
+		set_REN;
+#else
 	/* UART0 can use Timer 1 or Timer 3 as baud rate clock source */
 	/* Select Timer 3 to be consistent with UART1 which can use only T3 */
 	set_BRCK;
@@ -80,6 +118,7 @@ void uart_init(enum UART_BR baudrate, bool rx_enable)
 		P07_Quasi_Mode;	/* UART0 RX pin */
 		set_REN;		/* Receive enabled */
 	}
+#endif
 #elif USE_UART == 1
 	SCON_1 = 0x40;		/* UART1 Mode 1 */
 	/* UART1 can use only Timer 3 devided by 16 as baud rate clock source in mode 1*/
@@ -89,22 +128,59 @@ void uart_init(enum UART_BR baudrate, bool rx_enable)
 		set_REN_1;		/* Receive enabled */
 	}
 #endif
+#ifndef SIM_S51
 	RH3 = br_reload[baudrate][0];
 	RL3 = br_reload[baudrate][1];
 	T3CON &= 0xF8;	/* set pre-scale 1/1 */
-	tx_empty = 1;
 	set_TR3;		/* start Timer 3 */
+#endif
+	tx_empty = 1;
 }
 
 void uart_interrupt_handler(void) INTERRUPT(IRQ_UART,IRQ_UART_REG_BANK)
 {
+	PROF_ENTER();
+
 	if (UART_RI) {
 		UART_RI = 0;
+#ifdef UART_RX_RING
+		uint8_t ch = SBUF;
+		if (rx_num == UART_RX_SIZE)
+			rx_err = UART_ERR_OVERFLOW;
+		else {
+			rx_buffer[(rx_idx + rx_num) & UART_RX_MASK] = ch;
+			rx_num += 1;
+		}
+		/* one event per line, or if the line is too long to wait for its end,
+		   an event dropped on the full queue is retried on the next received char */
+		if (!rx_line && (rx_retry || (ch == '\r') || (ch == '\n') || (rx_num >= UART_RX_SIZE / 2))) {
+			rx_line = event_put(EVT_UART_LINE, rx_num);
+			rx_retry = !rx_line;
+		}
+#else
 		event_put(EVT_UART_RX, SBUF);
+#endif
 	}
 
 	if (UART_TI) {
 		UART_TI = 0;
+		if (desc_num) {
+			__xdata uart_desc_t *desc = tx_desc + desc_idx;
+			if (desc->before == 0) {
+				/* stream the block directly from its memory */
+				SBUF = *desc->buf;
+				desc->buf++;
+				desc->len -= 1;
+				if (desc->len == 0) {
+					event_put(EVT_UART_TX, desc->tag);
+					desc_idx = (desc_idx + 1) & UART_DESC_MASK;
+					desc_num -= 1;
+				}
+				PROF_EXIT(PROF_UART);
+				return;
+			}
+			desc->before -= 1;
+		}
 		if (tx_num) {
 			SBUF = tx_buffer[tx_idx];
 			tx_idx += 1;
@@ -113,6 +189,7 @@ void uart_interrupt_handler(void) INTERRUPT(IRQ_UART,IRQ_UART_REG_BANK)
 		} else
 			tx_empty = 1;
 	}
+	PROF_EXIT(PROF_UART);
 }
 
 bool uart_tx_empty(void)
@@ -120,6 +197,29 @@ bool uart_tx_empty(void)
 	return tx_empty;
 }
 
+#ifdef UART_RX_RING
+uint16_t uart_getc(void)
+{
+	val16_t ret;
+
+	ret.u16 = 0;
+	cli_es();
+	if (rx_num) {
+		ret.u8low = rx_buffer[rx_idx];
+		ret.u8high = UART_DATA_VALID;
+		rx_idx = (rx_idx + 1) & UART_RX_MASK;
+		rx_num -= 1;
+	}
+	/* the ring is drained, so allow the next EVT_UART_LINE */
+	if (rx_num == 0)
+		rx_line = rx_retry = 0;
+	ret.u8high |= rx_err;
+	rx_err = 0;
+	sti_es();
+	return ret.u16;
+}
+#endif
+
 /** send single char */
 void uart_putc(uint8_t ch)
 {
@@ -129,6 +229,7 @@ void uart_putc(uint8_t ch)
 	uint8_t tx_pos = (tx_idx + tx_num) & UART_BUF_MASK;
 	tx_buffer[tx_pos] = ch;
 	tx_num += 1;
+	tx_tail += 1;
 	if (tx_empty) {
 		sti_ti();
 		tx_empty = 0;
@@ -136,6 +237,28 @@ void uart_putc(uint8_t ch)
 	sti_es();
 }
 
+bool uart_write_desc(const uint8_t *buf, uint16_t len, uint8_t tag)
+{
+	if (!len || (desc_num == UART_DESC_NUM))
+		return false;
+
+	cli_es();
+	__xdata uart_desc_t *desc = tx_desc + ((desc_idx + desc_num) & UART_DESC_MASK);
+	desc->buf = buf;
+	desc->len = len;
+	desc->tag = tag;
+	/* bytes already in tx_buffer go first */
+	desc->before = desc_num ? tx_tail : tx_num;
+	tx_tail = 0;
+	desc_num += 1;
+	if (tx_empty) {
+		sti_ti();
+		tx_empty = 0;
+	}
+	sti_es();
+	return true;
+}
+
 /** send string from __code memory */
 void uart_putsc(__code const char *str)
 {
@@ -156,6 +279,16 @@ void uart_puts(__idata const char *str)
 	}
 }
 
+/** send string from __xdata memory */
+void uart_putx(__xdata const char *str)
+{
+	uint8_t ch = *str++;
+	while (ch) {
+		uart_putc(ch);
+		ch = *str++;
+	}
+}
+
 void uart_putbit(uint8_t val)
 {
 	uint8_t hex = '0';
@@ -182,51 +315,13 @@ void uart_puth(uint8_t val)
 /** print uint16_t in dec format left alighted */
 void uart_putn(uint16_t val)
 {
-	if (val == 0) {
-		uart_putc('0');
-		return;
-	}
-	uint8_t print = 0;
-	uint16_t div = 10000;
-	for (uint8_t i = 0; i < 5; i++) {
-		uint8_t byte = val / div;
-		if (byte)
-			print++;
-		if (print)
-			uart_putc(byte + '0');
-		val -= byte * div;
-		div /= 10;
-	}
-	return;
+	fmt_u16(val, 0, 0);
+	uart_putx(fmt_buf);
 }
 
-static __xdata uint8_t nbuf[6];
-
 /** print uint16_t in dec format right alignegd */
 void uart_putrn(uint16_t val)
 {
-	uint8_t print;
-	for (print = 0; print < 5; print++)
-		nbuf[print] = ' ';
-
-	nbuf[print] = '\0';
-	if (val == 0)
-		nbuf[4] = '0';
-	else {
-		uint16_t div = 10000;
-		print = 0;
-		for (uint8_t i = 0; i < 5; i++) {
-			uint8_t byte = val / div;
-			if (byte)
-				print++;
-			if (print)
-				nbuf[i] = byte + '0';
-			val -= byte * div;
-			div /= 10;
-		}
-	}
-
-	for (print = 0; print < 5; print++)
-		uart_putc(nbuf[print]);
-	return;
+	fmt_u16(val, 5, 0);
+	uart_putx(fmt_buf);
 }
@@ -6,6 +6,8 @@
   Default defines (can be changed in Makefile):
 	#define USE_UART 0 // select UART port 0 or 1
 	#define FOSC_16600 // system clock set to 16.600 MHz
+	#define UART_RX_RING // receive to xdata ring instead of EVT_UART_RX per byte
+	#define SIM_S51 // UART0 clocked by Timer 1 for s51 simulator without Timer 3
 */
 #ifndef N76E003_UART_H
 #define N76E003_UART_H
@@ -14,6 +16,7 @@
 #include <stdbool.h>
 
 #include "irq.h"
+#include "fmt.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -41,6 +44,22 @@ enum UART_BR {
 
 #define UART_BUF_SIZE 0x20 /**< buffer located in xdata, size must be power of 2 */
 
+/**
+ * If UART_RX_RING is defined then received bytes are stored in xdata ring
+ * buffer and one EVT_UART_LINE event is generated per received line
+ * ('\r' or '\n') or when the ring is half full, evt.data is number of
+ * bytes in the ring. Read the bytes with uart_getc() until it returns
+ * no UART_DATA_VALID flag or use cli_interact_line().
+ * Otherwise EVT_UART_RX event is generated for every received byte.
+ */
+#ifndef UART_RX_SIZE
+#define UART_RX_SIZE 0x40 /**< receive ring size, must be power of 2 */
+#endif
+
+#ifndef UART_DESC_NUM
+#define UART_DESC_NUM 4 /**< number of block descriptors, must be power of 2 */
+#endif
+
 #if USE_UART == 0
 	#define IRQ_UART IRQ_UART0
 #else
@@ -58,12 +77,29 @@ void uart_interrupt_handler(void) INTERRUPT(IRQ_UART,IRQ_UART_REG_BANK);
  */
 void uart_init(enum UART_BR baudrate, bool rx_enable);
 
+#ifdef UART_RX_RING
+/**
+ * get byte from the receive ring
+ * @return byte in LSB, UART_DATA_VALID and UART_ERR_OVERFLOW flags in MSB
+ */
 uint16_t uart_getc(void);
+#endif
 bool uart_tx_empty(void);
 
 void uart_putc(uint8_t ch);
 #define uart_putln() uart_putc('\n')
 
+/**
+ * queue block of data to be sent directly from its memory without copying
+ * to the transmit buffer, order with uart_putc() output is preserved
+ * @param buf generic pointer to __code, __xdata or __idata block,
+ *        must stay valid until EVT_UART_TX event
+ * @param len number of bytes to send, must not be 0
+ * @param tag EVT_UART_TX event data generated when the block is sent
+ * @return false if all UART_DESC_NUM descriptors are in use
+ */
+bool uart_write_desc(const uint8_t *buf, uint16_t len, uint8_t tag);
+
 /** print uint16_t in dec format */
 void uart_putn(uint16_t val);
 
@@ -78,6 +114,14 @@ void uart_puth(uint8_t val);
 void uart_putbit(uint8_t val);
 void uart_puts(__idata const char *str);
 void uart_putsc(__code const char *str);
+void uart_putx(__xdata const char *str);
+
+/** print uint32_t in dec format */
+#define uart_putl(val) do{fmt_u32(val,0,0);uart_putx(fmt_buf);}while(0)
+/** print int16_t in dec format */
+#define uart_putsn(val) do{fmt_s16(val,0,0);uart_putx(fmt_buf);}while(0)
+/** print fixed point number with dec digits after the point, "12.34" */
+#define uart_putfx(val, dec) do{fmt_fixed(val,dec,0,0);uart_putx(fmt_buf);}while(0)
 
 /** print uint8_t in hex with new line */
 #define uart_puthl(val); do{uart_puth(val);uart_putc('\n');}while(0)
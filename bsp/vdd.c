@@ -1,39 +1,102 @@
+/*
+  The MIT License (MIT)
+
+  Vdd measurement with ADC band-gap channel, requires iap_read.c
+
+  Configuration defines (can be changed in Makefile):
+	#define ADC_VDD_ASYNC // adc_vdd_start() driven by ADC interrupt, posts EVT_ADC
+	#define ADC_VDD_SAMPLES 5 // conversions per measurement, the last one is used
+*/
 #include <N76E003.h>
 
 #include "adc.h"
 #include "iap.h"
+#include "event.h"
+
+#ifndef ADC_VDD_SAMPLES
+#define ADC_VDD_SAMPLES 5
+#endif
 
 static uint16_t iap_bgap = 0;
+/* 4095 * band-gap in 1/4 mV, Vdd mV = vdd_scale / (4 * ADC) */
+static __xdata uint32_t vdd_scale;
+
+/** read band-gap calibration once, IAP must be enabled */
+static void bgap_init(void)
+{
+	iap_bgap = iap_read_uid(IAP_UID_SIZE);
+	iap_bgap <<= 4;
+	iap_bgap |= iap_read_uid(IAP_UID_SIZE + 1) & 0x0F;
+	/* band-gap mV = iap_bgap * 3072 / 4096 */
+	vdd_scale = (uint32_t)iap_bgap * (3 * 4095UL);
+}
+
+uint16_t adc_vdd_mv(uint16_t raw)
+{
+	if (raw == 0)
+		return 0;
+	return (uint16_t)(vdd_scale / ((uint32_t)raw << 2));
+}
 
 uint16_t adc_get_vdd(uint8_t mode)
 {
-	if (iap_bgap == 0) {
-		iap_bgap = iap_read_uid(IAP_UID_SIZE);
-		iap_bgap <<= 4;
-		iap_bgap |= iap_read_uid(IAP_UID_SIZE + 1) & 0x0F;
-	}
+	if (iap_bgap == 0)
+		bgap_init();
 
 	if (mode == ADC_GET_RAW_BGAP)
 		return iap_bgap;
 
-	float fgap = (float)iap_bgap * 3072.0;
-	fgap /= 4096.0;
-
-	uint16_t bgap = (uint16_t)fgap;
 	if (mode == ADC_GET_BGAP)
-		return bgap;
+		return (uint16_t)(((uint32_t)iap_bgap * 3) >> 2);
 
 	/* mode == ADC_GET_VDD */
 	/* read ADC synchronously, takes up to 400us */
 	Enable_ADC_BandGap;
-	for (uint8_t i = 0; i < 5; i++) {
+	for (uint8_t i = 0; i < ADC_VDD_SAMPLES; i++) {
 		clr_ADCF;
 		set_ADCS;
 		while (ADCF == 0);
 	}
-	/* convert to mV */
-	bgap = (ADCRH << 4) + ADCRL;
-	fgap = (4095.0 / bgap) * fgap;
-	bgap = (uint16_t)fgap;
-	return bgap;
+	return adc_vdd_mv((ADCRH << 4) + ADCRL);
+}
+
+#ifdef ADC_VDD_ASYNC
+static volatile uint8_t vdd_cnt;	/* conversions left */
+static volatile uint16_t vdd_raw;
+
+void adc_vdd_start(void)
+{
+	if (iap_bgap == 0)
+		bgap_init();
+
+	Enable_ADC_BandGap;
+	vdd_cnt = ADC_VDD_SAMPLES;
+	clr_ADCF;
+	set_EADC;
+	set_ADCS;
+}
+
+uint8_t adc_vdd_busy(void)
+{
+	return vdd_cnt;
+}
+
+uint16_t adc_vdd_result(void)
+{
+	if (vdd_cnt)
+		return 0;
+	return adc_vdd_mv(vdd_raw);
+}
+
+void adc_interrupt_handler(void) INTERRUPT(IRQ_ADC, IRQ_ADC_REG_BANK)
+{
+	clr_ADCF;
+	if (--vdd_cnt) {
+		set_ADCS;
+		return;
+	}
+	vdd_raw = (ADCRH << 4) + ADCRL;
+	clr_EADC;
+	event_put(EVT_ADC, ADC_BAND_GAP);
 }
+#endif
@@ -17,6 +17,7 @@
 #include <N76E003.h>
 #include <i2c.h>
 #include <tick.h>
+#include <fmt.h>
 
 #include "bv4618.h"
 
@@ -124,19 +125,11 @@ int8_t bv4618_puth(uint8_t val)
 /** print uint16_t in dec format */
 int8_t bv4618_putn(uint16_t val)
 {
-	if (val == 0)
-		return bv4618_putc('0');
+	int8_t ret = 0;
+	uint8_t i;
 
-	uint8_t print = 0;
-	uint16_t div = 10000;
-	for (uint8_t i = 0; i < 5; i++) {
-		uint8_t byte = val / div;
-		if (byte)
-			print++;
-		if (print)
-			bv4618_putc(byte + '0');
-		val -= byte * div;
-		div /= 10;
-	}
-	return 0;
+	fmt_u16(val, 0, 0);
+	for (i = 0; fmt_buf[i]; i++)
+		ret = bv4618_putc(fmt_buf[i]);
+	return ret;
 }
\ No newline at end of file
@@ -55,6 +55,14 @@ int8_t ds3231_rw(uint8_t addr, uint8_t len, uint8_t op);
 #define ds3231_read(addr,len) ds3231_rw(addr, len, I2C_READ)
 #define ds3231_write(addr,len) ds3231_rw(addr, len, I2C_WRITE)
 
+/**
+ * queue read of 'len' registers to the buffer, see ds3231_queue.c,
+ * the buffer is updated when EVT_I2C_STAT is received
+ * @param flags i2cq_submit() transaction tag and I2C_XFER_NOEVT
+ * @return I2C_EOK, I2C_EBUSY if the queue is full or I2C_EARG
+ */
+int8_t ds3231_aread(uint8_t addr, uint8_t len, uint8_t flags);
+
 /** turn 32kHz output on/off */
 int8_t ds3231_32k_enable(bool enable);
 /** turn SQW output on/off */
@@ -0,0 +1,27 @@
+/*
+  The MIT License (MIT)
+
+  Nuvoton N76E003 DS3231N RTC buffer reads using I2C transactions queue
+*/
+#include <N76E003.h>
+
+#include "i2c_queue.h"
+#include "ds3231.h"
+
+/* register address byte per queued transaction */
+static __xdata uint8_t areg[I2C_QUEUE_SIZE];
+static uint8_t aidx;
+
+int8_t ds3231_aread(uint8_t addr, uint8_t len, uint8_t flags)
+{
+	__xdata uint8_t *reg = areg + aidx;
+	int8_t ret;
+
+	if (!len || ((uint8_t)(addr + len) > DS3231_BUF_SIZE))
+		return I2C_EARG;
+	*reg = addr;
+	ret = i2cq_submit(I2C_DS3231, reg, 1, ds3231 + addr, len, flags);
+	if (ret == I2C_EOK)
+		aidx = (aidx + 1) & (I2C_QUEUE_SIZE - 1);
+	return ret;
+}
@@ -21,6 +21,36 @@
 /* unselect and restore data to 1 */
 #define ht1621_unselect() ht1621_set_cs(1); ht1621_set_data(1)
 
+/* sbit names for assembler, sdcc adds '_' to C names */
+#define _HT_STR(s) #s
+#define HT_STR(s) _HT_STR(s)
+#define HT_WR_ASM	"_" HT_STR(HT_WR_PIN)
+#define HT_DATA_ASM	"_" HT_STR(HT_DATA_PIN)
+#define HT_NOPS		"\n nop\n nop\n" /* the same as ht1621_set_*() */
+
+/* one WR clock, the data bit is shifted out of 'a' to carry */
+#define HT_BIT(rot) \
+	" clr " HT_WR_ASM HT_NOPS \
+	" " rot " a\n" \
+	" mov " HT_DATA_ASM ",c" HT_NOPS \
+	" setb " HT_WR_ASM HT_NOPS
+#define HT_BYTE(rot) HT_BIT(rot) HT_BIT(rot) HT_BIT(rot) HT_BIT(rot) \
+	HT_BIT(rot) HT_BIT(rot) HT_BIT(rot) HT_BIT(rot)
+
+/** unrolled write of 8 bits of the 'data', MSB first */
+static void ht1621_write_msb8(uint8_t data) __naked
+{
+	data; /* passed in dpl */
+	__asm__(" mov a,dpl\n" HT_BYTE("rlc") " ret");
+}
+
+/** unrolled write of 8 bits of the 'data', LSB first */
+static void ht1621_write_lsb8(uint8_t data) __naked
+{
+	data; /* passed in dpl */
+	__asm__(" mov a,dpl\n" HT_BYTE("rrc") " ret");
+}
+
 /** generic write of 'len' MSB of the 'data' */
 static void ht1621_write_msb(uint8_t data, uint8_t len)
 {
@@ -54,7 +84,7 @@ void ht1621_write_cmd(uint8_t cmd)
 	ht1621_select();
 	/* command is pushed MSB first */
 	ht1621_write_msb(HT1621_WRCMD, 2);
-	ht1621_write_msb(cmd, 8);
+	ht1621_write_msb8(cmd);
 	ht1621_write_msb(0, 1);
 	ht1621_unselect();
 }
@@ -91,7 +121,7 @@ void ht1621_write_seg(uint8_t seg, uint8_t data)
 	addr |= HT1621_WRDATA;
 	ht1621_select();
 	/* address is shifted MSB first */
-	ht1621_write_msb(addr, 8);
+	ht1621_write_msb8(addr);
 	/* data is shifted LSB first */
 	ht1621_write_lsb(data, 4);
 	ht1621_unselect();
@@ -108,8 +138,26 @@ void ht1621_write_data(uint8_t seg, uint8_t data)
 	addr |= HT1621_WRDATA;
 	ht1621_select();
 	/* address is shifted MSB first */
-	ht1621_write_msb(addr, 8);
+	ht1621_write_msb8(addr);
 	/* data is shifted LSB first */
-	ht1621_write_lsb(data, 8);
+	ht1621_write_lsb8(data);
+	ht1621_unselect();
+}
+
+/**
+ * Successive segments write of the whole block, address is
+ * incremented by HT1621 after each 4 bits of data,
+ * 'ht1621' bench of pys/sim-s51.py compares it with per byte writes
+ */
+void ht1621_write_block(uint8_t seg, __xdata const uint8_t *buf, uint8_t len)
+{
+	uint8_t addr = seg & 0x3F;
+	addr |= HT1621_WRDATA;
+	ht1621_select();
+	ht1621_write_msb8(addr);
+	while (len--) {
+		ht1621_write_lsb8(*buf);
+		buf++;
+	}
 	ht1621_unselect();
 }
@@ -92,6 +92,12 @@ void ht1621_write_seg(uint8_t seg, uint8_t data);
 /** address of the starting segment and 8 bits of data */
 void ht1621_write_data(uint8_t address, uint8_t data);
 
+/**
+ * write 'len' bytes to successive segments in one transaction,
+ * each byte is two segments: low nibble to 'seg', high nibble to 'seg' + 1
+ */
+void ht1621_write_block(uint8_t seg, __xdata const uint8_t *buf, uint8_t len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -3,23 +3,57 @@
 
   Simple driver for LCD installed on XY-LPWM and some others
   devices driven by N76E003.
+
+  All changes go to lcd_buf and mark its bytes dirty, lcd_flush()
+  writes dirty bytes to HT1621 in successive address transactions.
+
+  Configuration defines (can be changed in Makefile):
+    #define LCD_FLUSH // compose the screen, application calls lcd_flush()
 */
 #include <N76E003.h>
 
 #include "ht1621.h"
 #include "lcd_lpwm.h"
 #include "uart.h"
+#include "fmt.h"
 
 #define LCD_BUF_SIZE (LCD_NUM_SEGMENTS / 2)
 
 static __xdata uint8_t lcd_buf[LCD_BUF_SIZE];
+static uint16_t lcd_dirty; /* bit per lcd_buf byte */
+
+#define LCD_DIRTY_ALL ((1 << LCD_BUF_SIZE) - 1)
+
+/* without LCD_FLUSH every change is written at once */
+#ifdef LCD_FLUSH
+#define lcd_sync()
+#else
+#define lcd_sync() lcd_flush()
+#endif
+
+void lcd_flush(void)
+{
+	uint16_t dirty = lcd_dirty;
+	uint8_t start = 0, len;
+
+	lcd_dirty = 0;
+	while (dirty) {
+		for (; !(dirty & 0x01); dirty >>= 1)
+			start++;
+		/* a clean byte between dirty ones is cheaper than a new address */
+		for (len = 0; dirty & 0x03; dirty >>= 1)
+			len++;
+		ht1621_write_block(start * 2, lcd_buf + start, len);
+		start += len;
+	}
+}
 
 void lcd_buf_init(uint8_t fill)
 {
-	for (uint8_t i = 0; i < LCD_BUF_SIZE; i++) {
+	for (uint8_t i = 0; i < LCD_BUF_SIZE; i++)
 		lcd_buf[i] = fill;
-		ht1621_write_data(i*2, fill);
-	}
+	lcd_dirty = LCD_DIRTY_ALL;
+	lcd_flush();
 }
 
 /**
@@ -43,7 +77,8 @@ void _set_sign(uint8_t sign, bool set)
 	else
 		data &= ~mask;
 	lcd_buf[idx] = data;
-	ht1621_write_data(idx * 2, data);
+	lcd_dirty |= 1 << idx;
+	lcd_sync();
 }
 
 /**
@@ -61,27 +96,30 @@ void _set_sign(uint8_t sign, bool set)
  *   'h': h
  */
 
-static const uint8_t lcd_signs[] = {
-	LCD_SIG_DOT0, 	 0x77,  LCD_SIG_DOT1, 	 0x67,
-	LCD_SIG_DOT2, 	 0x57,  LCD_SIG_DOT3, 	 0x47,
-	LCD_SIG_DOT4, 	 0x07,	LCD_SIG_DOT5, 	 0x17,
-	LCD_SIG_DOT6, 	 0x27,	LCD_SIG_DOT7, 	 0x37,
-	LCD_SIG_V, 		 0x47,  LCD_SIG_COLON, 	 0x37,
-	LCD_SIG_IN, 	 0x84,	LCD_SIG_OUT, 	 0x85,
-	LCD_SIG_CGRAD, 	 0x87,	LCD_SIG_W, 		 0x40,
-	LCD_SIG_PERCENT, 0x41,	LCD_SIG_A,		 0x43,
-	LCD_SIG_h,		 0x42,	LCD_SIG_SET, 	 0x86,
+/* signs are indexed by acronym from '%' to 'h', 0 - not a sign */
+#define LCD_SIG_FIRST	LCD_SIG_PERCENT
+#define LCD_SIG_LAST	LCD_SIG_h
+#define SIG(s) [(s) - LCD_SIG_FIRST]
+
+static const uint8_t lcd_signs[LCD_SIG_LAST - LCD_SIG_FIRST + 1] = {
+	SIG(LCD_SIG_DOT0) = 0x77,	SIG(LCD_SIG_DOT1) = 0x67,
+	SIG(LCD_SIG_DOT2) = 0x57,	SIG(LCD_SIG_DOT3) = 0x47,
+	SIG(LCD_SIG_DOT4) = 0x07,	SIG(LCD_SIG_DOT5) = 0x17,
+	SIG(LCD_SIG_DOT6) = 0x27,	SIG(LCD_SIG_DOT7) = 0x37,
+	SIG(LCD_SIG_V) = 0x47,		SIG(LCD_SIG_COLON) = 0x37,
+	SIG(LCD_SIG_IN) = 0x84,		SIG(LCD_SIG_OUT) = 0x85,
+	SIG(LCD_SIG_CGRAD) = 0x87,	SIG(LCD_SIG_W) = 0x40,
+	SIG(LCD_SIG_PERCENT) = 0x41, SIG(LCD_SIG_A) = 0x43,
+	SIG(LCD_SIG_h) = 0x42,		SIG(LCD_SIG_SET) = 0x86,
 };
 
 void lcd_set_sign(uint8_t sign, bool set)
 {
-	for (uint8_t idx = 0; idx < sizeof(lcd_signs); idx += 2) {
-		if (lcd_signs[idx] == sign) {
-			_set_sign(lcd_signs[++idx], set);
-			return;
-		}
-	}
-	return;
+	if (sign < LCD_SIG_FIRST || sign > LCD_SIG_LAST)
+		return;
+	sign = lcd_signs[sign - LCD_SIG_FIRST];
+	if (sign)
+		_set_sign(sign, set);
 }
 
 void lcd_set_dot(uint8_t idx, bool set)
@@ -95,52 +133,33 @@ static const uint8_t digit_addr[LCD_NUM_DIGITS] = {
 	15, 13, 11, 9, 0, 2, 4, 6
 };
 
-/**
- * get one data byte starting from the given segment index/
- * for odd segments the data is split between two bytes
- * @param seg start map segment for a digit
- */
-static uint8_t lcd_get_digit(uint8_t seg)
-{
-	if (!(seg & 0x01))
-		return lcd_buf[seg >> 1];
-	seg >>= 1;
-	uint8_t data = lcd_buf[seg];
-	data &= 0xF0;
-	data |= lcd_buf[seg + 1] & 0x0F;
-	return data;
-}
-
 /* display digit but preserve corresponding 'dot' value */
 static void _set_digit(uint8_t idx, uint8_t val)
 {
 	uint8_t data;
 	idx = digit_addr[idx]; /* get digit's start map segment index */
-	data = lcd_get_digit(idx); /* get buffer data for this segment */
-	data &= 0x80; /* keep the highest bit unchanged - it stores 'dot' for the digit */
-	data |= val;
-	if (idx > 6)
-		data = swap8(data);
-	ht1621_write_data(idx, data);
 
 	/* idx is a segment address */
 	/* for line 0 we need to translate it to bytes */
 	idx >>= 1; /* byte index in the buffer */
 	data = lcd_buf[idx];
 	if (idx > 3) {
+		/* odd segment, the digit is split between two bytes */
 		data &= 0x8F;
 		data |= val & 0x70;
 		lcd_buf[idx] = data;
+		lcd_dirty |= 1 << idx;
 		idx += 1;
 		data = lcd_buf[idx];
 		data &= 0xF0;
 		data |= val & 0x0F;
 	} else {
-		data &= 0x80;
+		data &= 0x80; /* keep the highest bit unchanged - it stores 'dot' for the digit */
 		data |= val;
 	}
 	lcd_buf[idx] = data;
-	return;
+	lcd_dirty |= 1 << idx;
+	lcd_sync();
 }
 
 /* hexadecimal digits */
@@ -194,32 +213,19 @@ void lcd_set_symbol(uint8_t idx, uint8_t val)
 
 void lcd_printn(uint16_t num, uint8_t dstart, uint8_t width)
 {
-	uint8_t n;
-	uint16_t div = 1;
+	uint8_t n, len;
 
 	if (width > 4) width = 4;
-	for (n = 1; n < width; n++)
-		div *= 10;
-
-	if (num > 999) {
-		n = 4;
-		if (num > 9999)
-			num = 9999;
-	} else if (num > 99)
-		n = 3;
-	else if (num > 9)
-		n = 2;
-	else
-		n = 1;
+	if (num > 9999)
+		num = 9999;
 
-	for (; width; dstart++) {
-		if (width > n)
+	/* the lowest width digits if the number does not fit */
+	len = fmt_u16(num, width, 0);
+	for (n = len - width; n < len; n++, dstart++) {
+		if (fmt_buf[n] == ' ')
 			lcd_set_symbol(dstart & 0x07, ' ');
 		else
-			lcd_set_digit(dstart & 0x07, num / div);
-		num %= div;
-		div /= 10;
-		width--;
+			lcd_set_digit(dstart & 0x07, fmt_buf[n] - '0');
 	}
 }
 
@@ -238,18 +244,17 @@ void lcd_set_raw(uint8_t idx, uint8_t val)
 	if (idx >= LCD_NUM_DIGITS)
 		return;
 	idx = digit_addr[idx];	   /* get digit's start map segment index */
-	if (idx > 6)
-		val = swap8(val);
-	ht1621_write_data(idx, val);
 
 	/* idx is a segment address */
 	/* for line 0 we need to translate it to bytes */
 	idx >>= 1; /* byte index in the buffer */
 	uint8_t data = lcd_buf[idx];
 	if (idx > 3) {
+		/* the high nibble goes to the odd segment, see _set_digit() */
 		data &= 0x0F;
 		data |= val & 0xF0;
 		lcd_buf[idx] = data;
+		lcd_dirty |= 1 << idx;
 		idx += 1;
 		data = lcd_buf[idx];
 		data &= 0xF0;
@@ -258,6 +263,7 @@ void lcd_set_raw(uint8_t idx, uint8_t val)
 		data = val;
 	}
 	lcd_buf[idx] = data;
-	return;
+	lcd_dirty |= 1 << idx;
+	lcd_sync();
 }
 #endif
\ No newline at end of file
@@ -17,7 +17,13 @@ extern "C" {
 #define LCD_NUM_SEGMENTS 18 /** size of active HT1621 segments map */
 
 void lcd_init(uint8_t fill);
+/** fill the buffer and write the whole screen at once */
 void lcd_buf_init(uint8_t fill);
+/**
+ * write changed bytes of the buffer, must be called with LCD_FLUSH,
+ * does nothing without it, samples sharing lcd_lpwm.rel call it anyway
+ */
+void lcd_flush(void);
 #define lcd_clear() lcd_buf_init(0)
 #define lcd_fill() lcd_buf_init(0xFF)
 
@@ -13,6 +13,7 @@
 #include <N76E003.h>
 #include <i2c.h>
 #include <tick.h>
+#include <fmt.h>
 
 #include "pcf8574.h"
 
@@ -46,6 +47,10 @@ static uint8_t backlight;
 static uint8_t cur_pos, cur_line;
 /* display/cursor on/of flags */
 static __xdata uint8_t display_ctl;
+/* pcf_begin() nesting, I2C transaction is open if not 0 */
+static uint8_t stream;
+/* i2c_start() error of the open transaction, reset by pcf_end() */
+static int8_t stream_err;
 
 /**
  * raw I2C write of 8 bits:
@@ -60,6 +65,9 @@ static __xdata uint8_t display_ctl;
  */
 static int8_t pcf_i2c_write(uint8_t data)
 {
+	if (stream)
+		return stream_err ? stream_err : i2c_write(data);
+
 	int8_t ret = I2C_ESTART;
 	if (i2c_start(I2C_PCF8574 | I2C_WRITE) == I2C_EOK) {
 		i2c_write(data);
@@ -70,11 +78,25 @@ static int8_t pcf_i2c_write(uint8_t data)
 	return ret;
 }
 
+void pcf_begin(void)
+{
+	if (stream++ == 0 && i2c_start(I2C_PCF8574 | I2C_WRITE) != I2C_EOK)
+		stream_err = I2C_ESTART;
+}
+
+void pcf_end(void)
+{
+	if (stream && --stream == 0) {
+		i2c_stop();
+		stream_err = I2C_EOK;
+	}
+}
+
 /**
- * writes 4bits of data to lcd controller in 3 steps:
- * 0: writes data with E bit set to 0
- * 1: writes data with E bit set to 1
- * 2: writes data with E bit set to 0
+ * writes 4bits of data to lcd controller in 2 steps:
+ * 0: writes data with E bit set to 1
+ * 1: writes data with E bit set to 0
+ * an I2C byte takes 90 usec at 100 kHz, longer than E pulse width
  *
  * @param data high four bits are mapped to D7-D4, lower four bits LED,E,RW,RS
  */
@@ -83,16 +105,15 @@ static void pcf_write_4bits(uint8_t data)
 	/* make sure that we set backlight bit if needed */
 	data |= backlight;
 	pcf_i2c_write(data | LCD_PIN_E); /* set E high */
-	delay_mks(0);
 	pcf_i2c_write(data); /* set E low to initialize write */
-	delay_mks(0);
 }
 
 void pcf_send_cmd(uint8_t value)
 {
 	pcf_write_4bits((value & 0xf0));
 	pcf_write_4bits(((value << 4) & 0xf0));
-	delay_mks(35); /* data write delay */
+	if (!stream)
+		delay_mks(35); /* data write delay, the next byte takes longer in stream */
 }
 
 void pcf_send_data(uint8_t value)
@@ -100,7 +121,8 @@ void pcf_send_data(uint8_t value)
 	/* for data mode RS bit is set */
 	pcf_write_4bits((value & 0xf0) | LCD_PIN_RS);
 	pcf_write_4bits(((value << 4) & 0xf0) | LCD_PIN_RS);
-	delay_mks(35); /* data write delay */
+	if (!stream)
+		delay_mks(35); /* data write delay, the next byte takes longer in stream */
 }
 
 /* I2C clock should be set to 100K for PCF8574 to work stable */
@@ -217,16 +239,20 @@ void pcf_putc(uint8_t ch)
 /** print string from data segment */
 void pcf_puts(__idata const char *str)
 {
+	pcf_begin();
 	while(*str)
 		pcf_putc(*str++);
+	pcf_end();
 	return;
 }
 
 /** print string from code segment */
 void pcf_putsc(__code const char *str)
 {
+	pcf_begin();
 	while (*str)
 		pcf_putc(*str++);
+	pcf_end();
 	return;
 }
 
@@ -234,6 +260,7 @@ void pcf_putsc(__code const char *str)
 void pcf_puth(uint8_t val)
 {
 	uint8_t hex = val >> 4;
+	pcf_begin();
 	hex += '0';
 	if (hex > '9')
 		hex += 7;
@@ -243,27 +270,20 @@ void pcf_puth(uint8_t val)
 	if (hex > '9')
 		hex += 7;
 	pcf_putc(hex);
+	pcf_end();
 	return;
 }
 
 /** print uint16_t in dec format */
 void pcf_putn(uint16_t val)
 {
-	if (val == 0)
-		return pcf_putc('0');
-
-	uint8_t print = 0;
-	uint16_t div = 10000;
-	for (uint8_t i = 0; i < 5; i++) {
-		uint8_t byte = val / div;
-		if (byte)
-			print++;
-		if (print)
-			pcf_putc(byte + '0');
-		val -= byte * div;
-		div /= 10;
-	}
-	return;
+	uint8_t i;
+
+	fmt_u16(val, 0, 0);
+	pcf_begin();
+	for (i = 0; fmt_buf[i]; i++)
+		pcf_putc(fmt_buf[i]);
+	pcf_end();
 }
 
 /** clear line from cursor right */
@@ -273,18 +293,22 @@ void pcf_clright(void)
 		return;
 	uint8_t line = cur_line;
 	uint8_t pos = cur_pos;
+	pcf_begin();
 	/* cur_pos will be set to 0 by pcf_putc() when line is done */
 	while (cur_pos != 0)
 		pcf_putc(' ');
 	pcf_goto(line, pos);
+	pcf_end();
 	return;
 }
 
 /** clear entire line */
 void pcf_clline(void)
 {
+	pcf_begin();
 	pcf_goto(cur_line, 0);
 	for (uint8_t i = 0; i < PCF8574_CHARS; i++)
 		pcf_putc(' ');
 	pcf_goto(cur_line, 0);
+	pcf_end();
 }
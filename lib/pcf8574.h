@@ -76,6 +76,18 @@
 /** initialize 4bit mode and apply default configuration */
 void pcf_init(void);
 
+/**
+ * Open one I2C write transaction for all following calls up to pcf_end(),
+ * PCF8574 latches every byte, so E strobes of many characters are sent
+ * without start, address and stop per byte. HD44780 37 usec write time
+ * is covered by byte time at 100 kHz I2C clock, so delays are skipped.
+ * Calls can be nested, other I2C devices must not be used until pcf_end().
+ * If i2c_start() fails writes return I2C_ESTART until pcf_end().
+ */
+void pcf_begin(void);
+/** close the transaction of the outer pcf_begin() */
+void pcf_end(void);
+
 /** send byte in command mode */
 void pcf_send_cmd(uint8_t cmd);
 
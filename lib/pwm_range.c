@@ -3,6 +3,9 @@
 
   Simple routines to manipulate N76E003 PWM configuration.
   Not all available PWM features are enabled.
+
+  Integer only: the divider and duty counters are the same as the former
+  float code produced, see pys/pwm-range-check.py
 */
 #include <N76E003.h>
 
@@ -13,7 +16,9 @@
 #include "pwm_range.h"
 #include "terminal.h"
 
-static __xdata float duty_k;
+/* duty_k = pwm_div / 100 as the float it used to be: duty_m * 2^-duty_s */
+static __xdata uint32_t duty_m;
+static __xdata uint8_t duty_s;
 static __xdata uint8_t pwm_channels; /** mask of active PWM channels */
 static __xdata uint8_t pwm_duty[PWM_NUM_CHANNELS];  /** current PWM duty per channel */
 
@@ -47,20 +52,59 @@ void pwm_channel_init(uint8_t channel, uint8_t duty)
 	}
 }
 
+/** round to 24 significant bits, half to even as float operations do */
+static uint32_t round24(uint32_t val)
+{
+	uint32_t half, rem;
+	uint8_t t = 0;
+
+	while ((val >> t) >= 0x1000000UL)
+		t++;
+	if (t == 0)
+		return val;
+	half = 1UL << (t - 1);
+	rem = val & ((half << 1) - 1);
+	val -= rem;
+	if (rem > half || (rem == half && (val & (half << 1))))
+		val += half << 1;
+	return val;
+}
+
+/** duty counter for duty in percents */
+static uint16_t duty_counter(uint8_t duty)
+{
+	/* (uint16_t)(duty * duty_k + 0.5), rounding of the product itself
+	   does not change any result for 0-100% duties */
+	uint32_t val = (uint32_t)duty * duty_m + (1UL << (duty_s - 1));
+	return (uint16_t)(round24(val) >> duty_s);
+}
+
 /** sets duty in percents */
 void pwm_channel_set_duty(uint8_t channel, uint8_t duty)
 {
-	uint16_t duty_counter = (uint16_t)(duty * duty_k + 0.5);
+	uint16_t counter = duty_counter(duty);
+
+	pwm_duty[channel] = duty;
+#ifdef PWM_SHADOW
+	/* applied now or by the next pwm_shadow_commit() call */
+	pwm_shadow_duty(channel, counter);
+	pwm_shadow_commit();
+#else
 	if (PWMRUN)
 		while (LOAD); /* make sure that PWMCON0::LOAD is 0 */
 
-	pwm_duty_set(channel, duty_counter);
-	pwm_duty[channel] = duty;
+	pwm_duty_set(channel, counter);
 	LOAD = 1;
-
+#endif
 	return;
 }
 
+/** PWM clock per range and range multiplier of the 3 digit frequency */
+static const __code uint32_t range_fpwm[PWM_RANGE_NUM] = {
+	HIRC_FREQ / 4, HIRC_FREQ / (12 * PWM_TIM1_RELOAD), HIRC_FREQ / 4, HIRC_FREQ / 4, HIRC_FREQ, HIRC_FREQ
+};
+static const __code uint16_t freq_k[PWM_RANGE_NUM] = { 1, 1, 1, 10, 100, 1000 };
+
 /**
  * @param pwm_freq 3 digit value for selected range, for example:
  * 		777 for PWM_RANGE_100HZ means 777. Hz
@@ -69,32 +113,52 @@ void pwm_channel_set_duty(uint8_t channel, uint8_t duty)
  */
 void pwm_set_freq(uint16_t pwm_freq, uint8_t range)
 {
-	uint32_t fpwm = HIRC_FREQ;
-	static const float freq_k[PWM_RANGE_NUM] = { 1, 1, 1, 10, 100, 1000 };
+	uint32_t fpwm = range_fpwm[range];
+	uint32_t fdiv = (uint32_t)pwm_freq * freq_k[range];
+	uint16_t pwm_div;
 
-	/* convert frequency to counters */
 	if (range == PWM_RANGE_1HZ) {
-		fpwm /= 12 * 22; // 62878L;
 		CKCON |= CKCON_PWMCKS; /* set PWM source TIM1 */
 		clr_PWMDIV1; /* set pwm pre-scaler to 0 */
 	} else {
 		CKCON &= ~CKCON_PWMCKS; /* set pwm source to Fsys */
-		if (range <= PWM_RANGE_1KHZ) {
-			fpwm /= 4;
+		if (range <= PWM_RANGE_1KHZ)
 			set_PWMDIV1; /* set pwm pre-scaler to 4 */
-		} else
+		else
 			clr_PWMDIV1; /* set pwm pre-scaler to 0 */
 	}
 
 	/* PWM frequency = Fpwm/((PWMPH,PWMPL) + 1) */
 	/* PWM divider = Fpwm/(PWM frequency) - 1 */
-	float fdiv = (float)fpwm / ((float)pwm_freq * freq_k[range]);
 	if (range > PWM_RANGE_1KHZ)
-		fdiv += 0.5;
-
-	uint16_t pwm_div = (uint16_t)fdiv;
-	duty_k = pwm_div / 100.0;
+		fpwm += fdiv >> 1; /* rounded */
+	pwm_div = (uint16_t)(fpwm / fdiv);
+
+	/* duty_k = pwm_div / 100.0 rounded to 24 bit mantissa */
+	duty_s = 1;
+	duty_m = 0;
+	if (pwm_div) {
+		for (duty_s = 0; ((uint32_t)pwm_div << duty_s) < 100UL * 0x800000UL; duty_s++);
+		fpwm = (uint32_t)pwm_div << duty_s;
+		duty_m = fpwm / 100;
+		fpwm -= duty_m * 100;
+		if (fpwm > 50 || (fpwm == 50 && (duty_m & 1)))
+			duty_m++;
+		if (duty_m == 0x1000000UL) {
+			duty_m >>= 1;
+			duty_s--;
+		}
+	}
 
+#ifdef PWM_SHADOW
+	/* period and all duties are loaded together */
+	pwm_shadow_period(pwm_div);
+	for (uint8_t i = 0; i < PWM_NUM_CHANNELS; i++) {
+		if (pwm_channels & (0x01 << i))
+			pwm_shadow_duty(i, duty_counter(pwm_duty[i]));
+	}
+	pwm_shadow_commit();
+#else
 	while (LOAD); /* make sure that PWMCON0::LOAD is 0 */
 	PWMPH = HIBYTE(pwm_div);
 	PWMPL = LOBYTE(pwm_div);
@@ -103,4 +167,5 @@ void pwm_set_freq(uint16_t pwm_freq, uint8_t range)
 		if (pwm_channels & (0x01 << i))
 			pwm_channel_set_duty(i, pwm_duty[i]);
 	}
+#endif
 }
@@ -0,0 +1,122 @@
+# The MIT License (MIT)
+#
+# verify bsp/delay.h cycle exact delays in the s51 simulator from SDCC package
+#
+# Builds a test image with delay_cycles() and delay_us() calls separated
+# by calls to an empty mark() function, compiled with DELAY_CORE_8051
+# so the macros count classic 8051 machine cycles simulated by s51.
+# Then runs the image with a breakpoint on mark() and compares clocks
+# between the breakpoints with the requested number of cycles.
+# N76E003 clocks use the same macros with the datasheet instruction timings,
+# s51 can not check them, see delay.h for MARK_PIN check on the device.
+# Both FOSC_16000 and FOSC_16600 are checked unless --fosc is given.
+#
+#  > delay-s51.py [--fosc FOSC_16600] [--sdcc sdcc] [--s51 s51]
+#
+# will output
+#
+#   FOSC_16600
+#   macro                 cycles  s51 result
+#   --------------------- ------ ---- ------
+#   delay_cycles(0)            0    0 ok
+#   ...
+#
+# exits with 1 if any delay does not match
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+# s51 clocks per classic 8051 machine cycle
+CLOCKS_PER_CYCLE = 12
+# return from the mark() at the first breakpoint and call of the next one
+MARK_CYCLES = 2 + 2
+
+CYCLES = [0, 1, 2, 3, 7, 8, 9, 10, 11, 12, 31, 100, 255, 520, 521, 522, 523, 524,
+          1000, 4095, 10000, 65535]
+USECS = [1, 2, 5, 10, 35, 100, 250, 1000]
+
+HIRC_FREQ = {'FOSC_16000': 16000, 'FOSC_16600': 16600}
+
+BSPDIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'bsp')
+
+
+def us_cycles(us, fosc):
+    ''' the same rounding as DELAY_US_CYCLES() in delay.h '''
+    return (us * HIRC_FREQ[fosc] + 500) // 1000
+
+
+def build(tmp, fosc, sdcc):
+    tests = [('delay_cycles(%d)' % n, n) for n in CYCLES]
+    tests += [('delay_us(%d)' % us, us_cycles(us, fosc)) for us in USECS]
+
+    src = ['#include <N76E003.h>', '#include <delay.h>', '',
+           'void mark(void) __naked', '{', '\t__asm', '\tret', '\t__endasm;', '}', '',
+           'void main(void)', '{', '\tmark();']
+    for macro, _ in tests:
+        src.append('\t%s;' % macro)
+        src.append('\tmark();')
+    src += ['\twhile (1);', '}', '']
+    with open(os.path.join(tmp, 'main.c'), 'w') as f:
+        f.write('\n'.join(src))
+
+    cflags = ['-mmcs51', '--std-sdcc11', '-D' + fosc, '-DDELAY_CORE_8051', '-I' + BSPDIR]
+    for name in ('main.c', os.path.join(BSPDIR, 'delay.c')):
+        subprocess.run([sdcc] + cflags + ['-c', name], cwd=tmp, check=True)
+    subprocess.run([sdcc, '-mmcs51', '--code-size', '18432', '--xram-size', '768',
+                    'main.rel', 'delay.rel', '-o', 'main.ihx'], cwd=tmp, check=True)
+    return tests
+
+
+def mark_address(tmp):
+    with open(os.path.join(tmp, 'main.map')) as f:
+        for line in f:
+            m = re.search(r'C:\s+([0-9A-Fa-f]+)\s+_mark\b', line)
+            if m:
+                return int(m.group(1), 16)
+    raise RuntimeError('_mark is not found in main.map')
+
+
+def simulate(tmp, s51, hits):
+    cmds = ['break 0x%04x' % mark_address(tmp)]
+    cmds += ['run', 'state'] * hits
+    cmds += ['quit', '']
+    out = subprocess.run([s51, '-t', '8052', 'main.ihx'], cwd=tmp, input='\n'.join(cmds),
+                         capture_output=True, text=True).stdout
+    clocks = [int(x) for x in re.findall(r'\((\d+)\s+clks\)', out)]
+    if len(clocks) != hits:
+        print(out)
+        raise RuntimeError('expected %d breakpoints, got %d' % (hits, len(clocks)))
+    return clocks
+
+
+def main():
+    parser = argparse.ArgumentParser(description='verify delay.h timings in s51')
+    parser.add_argument('--fosc', action='append', choices=HIRC_FREQ.keys(),
+                        help='system clock define, both by default')
+    parser.add_argument('--sdcc', default='sdcc')
+    parser.add_argument('--s51', default='s51')
+    args = parser.parse_args()
+
+    failed = 0
+    for fosc in args.fosc or HIRC_FREQ.keys():
+        with tempfile.TemporaryDirectory() as tmp:
+            tests = build(tmp, fosc, args.sdcc)
+            clocks = simulate(tmp, args.s51, len(tests) + 1)
+
+        print(fosc)
+        print('macro                 cycles   s51 result')
+        print('--------------------- ------ ------ ------')
+        for i, (macro, cycles) in enumerate(tests):
+            measured = (clocks[i + 1] - clocks[i]) // CLOCKS_PER_CYCLE - MARK_CYCLES
+            ok = measured == cycles
+            failed += not ok
+            print('%-21s %6d %6d %s' % (macro, cycles, measured, 'ok' if ok else 'FAIL'))
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,159 @@
+# The MIT License (MIT)
+#
+# check integer only lib/pwm_range.c against the former float computation
+#
+# lib/pwm_range.c is compiled by the host C compiler with stub N76E003 headers,
+# pwm_set_freq() and pwm_channel_set_duty() are called for all ranges,
+# 3 digit frequencies and 0-100% duties and PWMP/PWMn values are compared
+# with the former float code emulated in IEEE single precision like sdcc
+# float, its formula and constants are copied to reference() below.
+# Frequencies with the divider out of 16 bits are not valid for the range
+# and are skipped.
+#
+#  > pwm-range-check.py [--fosc FOSC_16600] [--cc cc]
+#
+# will output
+#
+#   range    freqs   values mismatches
+#   ----- -------- -------- ----------
+#       1      999   101898          0
+#   ...
+#
+# exits with 1 on any mismatch
+
+import argparse
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+
+HIRC_FREQ = {'FOSC_16000': 16000000, 'FOSC_16600': 16600000}
+RANGES = range(1, 6)
+# the former float code constants: freq_k[] per range,
+# Fsys/12 Timer 1 with reload 22 for PWM_RANGE_1HZ and PWMDIV 4 up to 1 kHz
+FREQ_K = [1, 1, 1, 10, 100, 1000]
+TIM1_DIV = 12 * 22
+PWM_DIV = 4
+
+LIBDIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'lib')
+
+STUBS = {
+    'N76E003.h': '''#include <stdint.h>
+#define __xdata
+#define __code
+#define HIRC_FREQ %dL
+#define HIBYTE(v) ((uint8_t)((v) >> 8))
+#define LOBYTE(v) ((uint8_t)(v))
+#define CKCON_T1M 0x10
+#define CKCON_PWMCKS 0x40
+#define set_PWMDIV1
+#define clr_PWMDIV1
+extern uint8_t CKCON, TMOD, TH1, TL1, TR1, PWMPH, PWMPL, LOAD, PWMRUN;
+''',
+    'irq.h': '',
+    'terminal.h': '',
+    'pwm.h': '''#include <stdint.h>
+#define PWM_NUM_CHANNELS 6
+void pwm_duty_set(uint8_t channel, uint16_t duty);
+''',
+    'host.c': '''#include <stdio.h>
+#include <stdlib.h>
+#include "pwm_range.h"
+uint8_t CKCON, TMOD, TH1, TL1, TR1, PWMPH, PWMPL, LOAD, PWMRUN;
+static uint16_t duty_reg;
+void pwm_duty_set(uint8_t channel, uint16_t duty) { (void)channel; duty_reg = duty; }
+
+/* stdin: range freq lines, stdout: PWMP and 101 duty counters */
+int main(void)
+{
+	unsigned range, freq, duty;
+	pwm_init_timer();
+	pwm_channel_init(0, 0);
+	while (scanf("%u %u", &range, &freq) == 2) {
+		LOAD = 0; /* PWM hardware clears it when the period ends */
+		pwm_set_freq(freq, range);
+		printf("%u", (PWMPH << 8) | PWMPL);
+		for (duty = 0; duty <= 100; duty++) {
+			pwm_channel_set_duty(0, duty);
+			printf(" %u", duty_reg);
+		}
+		printf("\\n");
+	}
+	return 0;
+}
+''',
+}
+
+
+def f32(x):
+    return struct.unpack('f', struct.pack('f', x))[0]
+
+
+def reference(hirc, freq, rng):
+    ''' the former float code of pwm_set_freq() and pwm_channel_set_duty():
+        fdiv = (float)fpwm / ((float)pwm_freq * freq_k[range]), + 0.5 above 1 kHz range
+        duty_k = pwm_div / 100.0, duty counter = (uint16_t)(duty * duty_k + 0.5) '''
+    fpwm = hirc
+    if rng == 1:
+        fpwm //= TIM1_DIV
+    elif rng <= 3:
+        fpwm //= PWM_DIV
+    fdiv = f32(f32(float(fpwm)) / f32(float(freq * FREQ_K[rng])))
+    if rng > 3:
+        fdiv = f32(fdiv + 0.5)
+    pwm_div = int(fdiv)
+    if pwm_div > 0xFFFF:
+        return None
+    duty_k = f32(pwm_div / 100.0)
+    return [pwm_div] + [int(f32(f32(duty * duty_k) + 0.5)) for duty in range(101)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='check lib/pwm_range.c against float reference')
+    parser.add_argument('--fosc', default='FOSC_16600', choices=HIRC_FREQ.keys())
+    parser.add_argument('--cc', default='cc')
+    args = parser.parse_args()
+    hirc = HIRC_FREQ[args.fosc]
+
+    cases = []
+    for rng in RANGES:
+        for freq in range(1, 1000):
+            ref = reference(hirc, freq, rng)
+            if ref:
+                cases.append((rng, freq, ref))
+
+    with tempfile.TemporaryDirectory() as tmp:
+        for name, text in STUBS.items():
+            with open(os.path.join(tmp, name), 'w') as f:
+                f.write(text % hirc if name == 'N76E003.h' else text)
+        exe = os.path.join(tmp, 'pwm_range')
+        subprocess.run([args.cc, '-O1', '-I' + tmp, '-I' + LIBDIR, '-o', exe,
+                        os.path.join(tmp, 'host.c'), os.path.join(LIBDIR, 'pwm_range.c')], check=True)
+        out = subprocess.run([exe], input=''.join('%d %d\n' % (r, f) for r, f, _ in cases),
+                             capture_output=True, text=True, check=True).stdout.split('\n')
+
+    failed = 0
+    print('range    freqs   values mismatches')
+    print('----- -------- -------- ----------')
+    for rng in RANGES:
+        freqs = values = bad = 0
+        for (r, freq, ref), line in zip(cases, out):
+            if r != rng:
+                continue
+            got = [int(x) for x in line.split()]
+            freqs += 1
+            values += len(ref)
+            for i, (a, b) in enumerate(zip(ref, got)):
+                if a != b:
+                    if bad < 3:
+                        print('range %d freq %d %s: float %d, integer %d' %
+                              (rng, freq, 'PWMP' if i == 0 else 'duty %d%%' % (i - 1), a, b))
+                    bad += 1
+        failed += bad
+        print('%5d %8d %8d %10d' % (rng, freqs, values, bad))
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
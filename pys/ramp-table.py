@@ -0,0 +1,70 @@
+# The MIT License (MIT)
+#
+# generates __code curve tables for bsp/pwm_ramp.c, so ramps do not need
+# any float or pow() math on the target
+#
+# Every curve has --points values for the ends of ramp intervals, 0 is the
+# ramp start and 255 is the target duty:
+#   linear       t
+#   gamma        t ^ gamma, linear perceived LED brightness
+#   exponential  (e ^ (k * t) - 1) / (e ^ k - 1)
+#
+#  > ramp-table.py --points 32 --gamma 2.2 --exp 5 -o pwm_ramp_tab.h
+#
+# the header is included by pwm_ramp.c from the sample folder, see
+# xsamples/pwm-low-power/Makefile
+
+import argparse
+import math
+import sys
+
+CURVES = ('linear', 'gamma', 'exp')
+
+
+def curve(name, t, args):
+    if name == 'gamma':
+        return t ** args.gamma
+    if name == 'exp':
+        return (math.exp(args.exp * t) - 1) / (math.exp(args.exp) - 1)
+    return t
+
+
+def main():
+    parser = argparse.ArgumentParser(description='PWM ramp curve tables for pwm_ramp.c')
+    parser.add_argument('--points', type=int, default=32, help='values per curve, 2 - 255')
+    parser.add_argument('--gamma', type=float, default=2.2)
+    parser.add_argument('--exp', type=float, default=5.0, help='exponential curve steepness')
+    parser.add_argument('-o', '--output', help='header file, stdout by default')
+    args = parser.parse_args()
+    if not 2 <= args.points <= 255:
+        parser.error('--points must be 2 - 255')
+
+    lines = [
+        '/* generated by pys/ramp-table.py --points %d --gamma %g --exp %g, do not edit */'
+        % (args.points, args.gamma, args.exp),
+        '#ifndef PWM_RAMP_TAB_H',
+        '#define PWM_RAMP_TAB_H',
+        '',
+        '#define PWM_RAMP_POINTS %d' % args.points,
+        '',
+        '/* curve value at (i + 1) / PWM_RAMP_POINTS of the ramp duration, 255 is the target */',
+        'static const __code uint8_t ramp_tab[][PWM_RAMP_POINTS] = {',
+    ]
+    for name in CURVES:
+        vals = [int(round(255 * curve(name, (i + 1) / args.points, args))) for i in range(args.points)]
+        lines.append('\t{ /* %s */' % name)
+        for i in range(0, len(vals), 16):
+            lines.append('\t\t' + ', '.join('%d' % v for v in vals[i:i + 16]) + ',')
+        lines.append('\t},')
+    lines += ['};', '', '#endif', '']
+
+    text = '\n'.join(lines)
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,456 @@
+# The MIT License (MIT)
+#
+# run BSP modules in the s51 simulator from SDCC package
+#
+# Each bench below is a small main() linked with bsp modules and compiled
+# with SIM_S51 defined, so UART0 is clocked by Timer 1 available in s51.
+# The image is run with UART0 connected to files: the bench input is fed
+# to RX and TX output is compared with the expected regular expression.
+# Calls to the empty mark() function are breakpoints placed in pairs around
+# measured code, s51 clocks between the pair are reported as a named interval
+# in classic 8051 machine cycles, worst case is kept if the pair repeats.
+#
+#  > sim-s51.py [--bench event] [--baseline sim.json [--save]] [--threshold 10]
+#
+# will output
+#
+#   bench    interval        cycles baseline
+#   -------- --------------- ------ --------
+#   event    event_put           nn       nn
+#   ...
+#
+# exits with 1 if the output does not match, an interval grows more than
+# threshold percents over the baseline or the interval is not in the baseline.
+# Baseline is written only with --save, after checking the reported cycles.
+# Modules using cli()/sti() or sfr_page() need N76E003.c for EA_SAVE.
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+# s51 clocks per classic 8051 machine cycle
+CLOCKS_PER_CYCLE = 12
+# return from mark() at the first breakpoint and call of the second one
+MARK_CYCLES = 2 + 2
+# breakpoint stops to run before giving up
+MAX_STOPS = 64
+
+BSPDIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'bsp')
+LIBDIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'lib')
+
+HEADER = '''#include <N76E003.h>
+#include <event.h>
+#include <uart.h>
+#include <terminal.h>
+#include <fmt.h>
+
+void mark(void) __naked
+{
+	__asm
+	ret
+	__endasm;
+}
+
+void done(void) __naked
+{
+	__asm
+	ret
+	__endasm;
+}
+'''
+
+# name: (modules relative to bsp, code, intervals for mark() pairs, UART input, expected UART output)
+BENCHES = {
+    'event': (['N76E003.c', 'event.c'], '''
+void main(void)
+{
+	event_t evt;
+	mark();
+	event_put(0x10, 1);
+	mark();
+	mark();
+	evt.evt = event_get();
+	mark();
+	mark();
+	event_put(EVT_TICK, 1);
+	event_put(EVT_TICK, 1); /* coalesced */
+	mark();
+	evt.evt = event_get();
+	done();
+	while (1);
+}
+''', ['event_put', 'event_get', 'event_put x2'], '', ''),
+
+    'uart': (['N76E003.c', 'event.c', 'uart.c', 'fmt.c'], '''
+void main(void)
+{
+	uart_init(UART_BR_115200, false);
+	EA = 1;
+	mark();
+	uart_putn(65535);
+	mark();
+	mark();
+	uart_putc(' ');
+	mark();
+	mark();
+	uart_puth(0xA5);
+	mark();
+	while (!uart_tx_empty());
+	done();
+	while (1);
+}
+''', ['uart_putn', 'uart_putc', 'uart_puth'], '', r'^65535 A5$'),
+
+    'cli': (['N76E003.c', 'event.c', 'uart.c', 'fmt.c', 'terminal.c'], '''
+static __bit quit;
+
+int8_t commander(__idata char *cmd)
+{
+	uart_putsc("ok:");
+	uart_puts(cmd);
+	uart_putc('\\n');
+	quit = str_is(cmd, "exit");
+	return CLI_EOK;
+}
+
+void main(void)
+{
+	event_t evt;
+	uart_init(UART_BR_115200, true);
+	EA = 1;
+	cli_init(commander);
+	while (!quit) {
+		evt.evt = event_get();
+		if (evt.type == EVT_UART_RX) {
+			mark();
+			cli_interact(evt.data);
+			mark();
+		}
+	}
+	while (!uart_tx_empty());
+	done();
+	while (1);
+}
+''', ['cli_interact'], 'abc\nexit\n', r'ok:abc\n.*ok:exit'),
+
+    'fmt': (['fmt.c'], '''
+static __xdata char nbuf[6];
+
+/* division loop of the former uart_putn() writing to a buffer */
+void div_u16(uint16_t val)
+{
+	uint8_t print = 0, n = 0;
+	uint16_t div = 10000;
+	for (uint8_t i = 0; i < 5; i++) {
+		uint8_t byte = val / div;
+		if (byte)
+			print++;
+		if (print || i == 4)
+			nbuf[n++] = byte + '0';
+		val -= byte * div;
+		div /= 10;
+	}
+	nbuf[n] = '\\0';
+}
+
+/* digits loop of the former lcd_printn() for width 4 */
+void div_lcd4(uint16_t num)
+{
+	uint16_t div = 1000;
+	uint8_t n;
+	for (n = 0; n < 4; n++) {
+		nbuf[n] = num / div;
+		num %= div;
+		div /= 10;
+	}
+}
+
+void main(void)
+{
+	mark();
+	div_u16(65535);
+	mark();
+	mark();
+	fmt_u16(65535, 0, 0);
+	mark();
+	mark();
+	div_u16(9);
+	mark();
+	mark();
+	fmt_u16(9, 0, 0);
+	mark();
+	mark();
+	fmt_u32(4294967295, 0, 0);
+	mark();
+	mark();
+	fmt_fixed(-1234, 2, 7, 0);
+	mark();
+	mark();
+	div_lcd4(9999);
+	mark();
+	mark();
+	fmt_u16(9999, 4, 0);
+	mark();
+	done();
+	while (1);
+}
+''', ['div 65535', 'fmt_u16 65535', 'div 9', 'fmt_u16 9', 'fmt_u32 max', 'fmt_fixed',
+              'lcd div 9999', 'fmt_u16 w4 9999'], '', ''),
+
+    'timer': (['N76E003.c', 'event.c', 'timer.c'], '''
+#include <timer.h>
+
+/* timer_tick() runs in the tick interrupt register bank, adds 6 cycles */
+void tick(void) __naked
+{
+	__asm
+	push	psw
+	mov	psw,#(IRQ_TICK_REG_BANK << 3)
+	lcall	_timer_tick
+	pop	psw
+	ret
+	__endasm;
+}
+
+void main(void)
+{
+	uint8_t i;
+	/* empty slot, the cost with no timers armed */
+	mark();
+	tick();
+	mark();
+	/* one one-shot timer expires */
+	timer_start(0, 1, 0, 0x20, 0);
+	mark();
+	tick();
+	mark();
+	mark();
+	timer_start(0, 1000, 0, 0x20, 0);
+	mark();
+	mark();
+	timer_start(0, 1000, 0, 0x20, 0); /* restart unlinks the timer */
+	mark();
+	/* all timers in the slot reached by the 8th tick, counting rounds */
+	for (i = 0; i < TIMER_NUM; i++)
+		timer_start(i, TIMER_SLOTS * (i + 2), 0, 0x20, i);
+	for (i = 0; i < TIMER_SLOTS; i++) {
+		mark();
+		tick();
+		mark();
+	}
+	/* all periodic timers expire on the next tick and are re-inserted */
+	for (i = 0; i < TIMER_NUM; i++)
+		timer_start(i, 1, 100, 0x20, i);
+	mark();
+	tick();
+	mark();
+	done();
+	while (1);
+}
+''', ['tick 0 armed', 'tick 1 fires', 'timer_start', 'timer_restart'] +
+        ['tick rounds'] * 8 + ['tick N fire'], '', ''),
+
+    'spi': (['N76E003.c', 'spi.c'], '''
+#include <spi.h>
+
+static __idata uint8_t ibuf[16];
+static __xdata uint8_t xbuf[16];
+
+/* the former bsp-spi sample loop with a generic pointer */
+void spi_send_generic(const uint8_t *buf, uint8_t len)
+{
+	while (len--) {
+		SPDR = *buf++;
+		while (SPSR & SPSR_TXBUF);
+	}
+}
+
+void main(void)
+{
+	/* s51 has no SPI, SPSR reads as written, so TXBUF is never set */
+	mark();
+	spi_send_generic(ibuf, 16);
+	mark();
+	mark();
+	spi_write_i(ibuf, 16);
+	mark();
+	mark();
+	spi_write_x(xbuf, 16);
+	mark();
+	done();
+	while (1);
+}
+''', ['generic 16', 'spi_write_i 16', 'spi_write_x 16'], '', ''),
+
+    'ht1621': (['../lib/ht1621.c'], '''
+#include <ht1621.h>
+
+/* lcd_lpwm.c screen, LCD_NUM_SEGMENTS / 2 bytes */
+static __xdata uint8_t screen[9];
+
+/* the former generic bit loops and lcd_buf_init() writing one byte per transaction */
+static void old_write(uint8_t data, uint8_t len, uint8_t msb)
+{
+	while (len) {
+		ht1621_set_wr(0);
+		ht1621_set_data(msb ? (data & 0x80) : (data & 0x01));
+		ht1621_set_wr(1);
+		if (msb)
+			data <<= 1;
+		else
+			data >>= 1;
+		len--;
+	}
+}
+
+void old_screen(void)
+{
+	uint8_t i;
+	for (i = 0; i < sizeof(screen); i++) {
+		ht1621_set_cs(0);
+		ht1621_set_wr(0);
+		ht1621_set_data(1);
+		ht1621_set_wr(1);
+		old_write(0x40 | (i * 2), 8, 1);
+		old_write(screen[i], 8, 0);
+		ht1621_set_cs(1);
+		ht1621_set_data(1);
+	}
+}
+
+void main(void)
+{
+	mark();
+	old_screen();
+	mark();
+	mark();
+	ht1621_write_block(0, screen, sizeof(screen));
+	mark();
+	done();
+	while (1);
+}
+''', ['old screen', 'write_block'], '', ''),
+}
+
+
+def build(tmp, name, sdcc, cflags):
+    modules, code, _, _, _ = BENCHES[name]
+    with open(os.path.join(tmp, 'main.c'), 'w') as f:
+        f.write(HEADER + code)
+    flags = ['-mmcs51', '--std-sdcc11', '-DSIM_S51', '-DFOSC_16000', '-I' + BSPDIR,
+             '-I' + LIBDIR] + cflags
+    rels = ['main.rel']
+    subprocess.run([sdcc] + flags + ['-c', 'main.c'], cwd=tmp, check=True)
+    for m in modules:
+        subprocess.run([sdcc] + flags + ['-c', os.path.join(BSPDIR, m)], cwd=tmp, check=True)
+        rels.append(os.path.basename(m).replace('.c', '.rel'))
+    subprocess.run([sdcc, '-mmcs51', '--code-size', '18432', '--xram-size', '768'] + rels +
+                   ['-o', 'main.ihx'], cwd=tmp, check=True)
+
+
+def symbol(tmp, name):
+    with open(os.path.join(tmp, 'main.map')) as f:
+        for line in f:
+            m = re.search(r'C:\s+([0-9A-Fa-f]+)\s+' + name + r'\b', line)
+            if m:
+                return int(m.group(1), 16)
+    raise RuntimeError(name + ' is not found in main.map')
+
+
+def simulate(tmp, name, s51):
+    _, _, intervals, uart_in, _ = BENCHES[name]
+    with open(os.path.join(tmp, 'uart.in'), 'w') as f:
+        f.write(uart_in)
+    open(os.path.join(tmp, 'uart.out'), 'w').close()
+
+    mark = symbol(tmp, '_mark')
+    done = symbol(tmp, '_done')
+    cmds = ['break 0x%04x' % mark, 'break 0x%04x' % done]
+    cmds += ['run', 'state'] * MAX_STOPS
+    cmds += ['quit', '']
+    proc = subprocess.run([s51, '-t', '8052', '-S', 'in=uart.in,out=uart.out', 'main.ihx'],
+                          cwd=tmp, input='\n'.join(cmds), capture_output=True, text=True,
+                          timeout=600)
+
+    # pair clocks with the breakpoint address of each stop
+    clocks = [int(x) for x in re.findall(r'\((\d+)\s+clks\)', proc.stdout)]
+    pcs = [int(x, 16) for x in re.findall(r'Stop at 0x([0-9A-Fa-f]+)', proc.stdout)]
+    stops = list(zip(pcs, clocks))
+    if done not in pcs:
+        print(proc.stdout)
+        raise RuntimeError(name + ': done() was not reached')
+
+    marks = [clk for pc, clk in stops[:pcs.index(done)] if pc == mark]
+    result = {}
+    for i in range(0, len(marks) - 1, 2):
+        label = intervals[(i // 2) % len(intervals)]
+        cycles = (marks[i + 1] - marks[i]) // CLOCKS_PER_CYCLE - MARK_CYCLES
+        result[label] = max(result.get(label, 0), cycles)
+
+    with open(os.path.join(tmp, 'uart.out'), errors='replace') as f:
+        output = f.read()
+    return result, output
+
+
+def main():
+    parser = argparse.ArgumentParser(description='run BSP benches in s51')
+    parser.add_argument('--bench', action='append', choices=BENCHES.keys(),
+                        help='bench to run, all by default')
+    parser.add_argument('--baseline', help='JSON file with cycles to compare with')
+    parser.add_argument('--save', action='store_true', help='update the baseline file')
+    parser.add_argument('--threshold', type=float, default=10.0,
+                        help='allowed cycles growth over the baseline, percents')
+    parser.add_argument('--sdcc', default='sdcc')
+    parser.add_argument('--s51', default='s51')
+    parser.add_argument('-D', dest='defines', action='append', default=[],
+                        help='extra define for bsp modules, for example -D EVENT_LANES=3')
+    args = parser.parse_args()
+
+    baseline = {}
+    if args.baseline and os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+    elif args.baseline and not args.save:
+        print('%s is not found, run with --save to create it' % args.baseline)
+        sys.exit(1)
+
+    failed = 0
+    results = {}
+    cflags = ['-D' + d for d in args.defines]
+    print('bench    interval        cycles baseline')
+    print('-------- --------------- ------ --------')
+    for name in args.bench or BENCHES.keys():
+        with tempfile.TemporaryDirectory() as tmp:
+            build(tmp, name, args.sdcc, cflags)
+            cycles, output = simulate(tmp, name, args.s51)
+        results[name] = cycles
+        for label, value in cycles.items():
+            base = baseline.get(name, {}).get(label)
+            status = ''
+            if args.baseline and not args.save and base is None:
+                status = ' NEW'
+                failed += 1
+            elif base is not None and value > base * (1 + args.threshold / 100):
+                status = ' FAIL'
+                failed += 1
+            print('%-8s %-15s %6d %8s%s' % (name, label, value, base if base is not None else '-', status))
+        expected = BENCHES[name][4]
+        if expected and not re.search(expected, output, re.S | re.M):
+            print('%-8s UART output mismatch: %r' % (name, output))
+            failed += 1
+
+    if args.baseline and args.save:
+        baseline.update(results)
+        with open(args.baseline, 'w') as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+            f.write('\n')
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
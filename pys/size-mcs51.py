@@ -1,7 +1,7 @@
 # The MIT License (MIT)
 #
-# .mem file parser for mcs51 target generated by sdcc linker
-# tested with SDCC 3.8.0
+# .mem and .map files parser for mcs51 target generated by sdcc linker
+# .mem parser tested with SDCC 3.8.0, per module .map report is not tested yet
 #
 # For parser to work correctly linker must have memory sizes passed as parameters,
 # for example, for Nuvoton N76E003:
@@ -20,17 +20,27 @@
 #   STACK            0x0034 0x00FF   204   248   204
 #   EXTERNAL RAM     0x0001 0x0049    73   768   695 90.5% free
 #   ROM/EPROM/FLASH  0x0000 0x0567  1384 18432 17048 92.5% free
+#
+# Optional arguments:
+#   --modules              per module code/xdata/data usage from .map file next to .mem
+#   --functions            per function code size from .map file
+#   --baseline base.json   compare with JSON report and exit with 1 if code,
+#   --threshold 32         xdata or idata (stack) grows more than threshold bytes,
+#                          missing baseline file is created
+#   --save                 update the baseline file
+#
+# Symbol sizes are distances between global symbols of the .map file,
+# so static functions and variables are counted to the preceding global one.
+# Images are named after the sample folder:
+#
+#  > size-mcs51.py --baseline size-baseline.json ../xsamples/*/main.mem
 
+import argparse
+import json
+import os
+import re
 import sys
 
-# must be called with a .mem file as the command line argument
-# tested with sdcc 3.8.0/python 3.7.2
-# change *_LINE constants below in case if .mem file format changes
-
-RAM_LINE   = 2
-XRAM_LINE  = 27
-ROM_LINE   = 28
-
 # default idata size for MCS 51
 IDATA_MAX = 256
 # max 4 reg banks for MCS 51
@@ -38,67 +48,222 @@ BANKS_MAX = 4
 # assume that stack uses idata and starts right after the first register bank
 STACK_MAX = IDATA_MAX - 8
 
-if (len(sys.argv) != 2):
-    print('Usage: size-mcs51.py file.mem ')
-    sys.exit()
-
-try:
-    file = open(sys.argv[1])
-except IOError:
-    print('Could not read file:', sys.argv[1])
-    sys.exit()
-
-lines = file.readlines()
-file.close()
-
-# ram will hold the string with the RAM layout
-ram = ''
-# read layout in the ram - extract only relevant bytes
-for i in range(RAM_LINE, RAM_LINE + 16):
-    ram += lines[i][5:37]
-
-# count reg banks, bank 0 always in use
-banks = 1
-# get the max index of the used reg bank
-if ram.count('|3'):
-    banks = 4
-elif ram.count('|2'):
-    banks = 3
-elif ram.count('|1'):
-    banks = 2
-# count overlays
-overlays = ram.count('|Q')
-# count stack bytes
-stack = ram.count('|S')
-# used idata
-idata = IDATA_MAX - stack
-
-print('')
-print('   Name              Start    End  Size   Max Spare')
-print('   ---------------- ------ ------ ----- ----- -----------')
-# registers banks
-print('   REG BANKS        0x0000 0x' + format(int(banks*8)-1, '04X'), '', end='')
-print(format(banks, '5d'), format(BANKS_MAX, '5d'), '', end='')
-print(format(BANKS_MAX - banks, '5d'))
-# DATA line
-print('   IDATA            0x0000 0x' + format(int(idata)-1, '04X'), '', end='')
-print(format(idata, '5d'), format(IDATA_MAX, '5d'), '', end='')
-print(format(IDATA_MAX - idata, '5d'))
-# OVERLAYS line
-if overlays:
-    print('   OVERLAYS                          ', overlays)
-# STACK line
-print('   STACK            0x' + format(int(idata), '04X'), '0x00FF ', end='')
-print(format(stack, '5d'), format(STACK_MAX, '5d'), format(stack, '5d'))
-# EXTERNAL RAM line
-list = lines[XRAM_LINE].split()
-print('  ', list[0], list[1], '   ', list[2], list[3], '', end='')
-print(format(int(list[4]), '5d'), format(int(list[5]), '5d'), '', end='')
-spare = int(list[5]) - int(list[4])
-print(format(spare, '5d'), format(100.0*float(spare)/float(list[5]), '.1f')+'% free')
-# ROM/EPROM/FLASH line
-list = lines[ROM_LINE].split()
-print('  ', list[0], '', list[1], list[2], '', end='')
-print(format(int(list[3]), '5d'), format(int(list[4]), '5d'), '', end='')
-spare = int(list[4]) - int(list[3])
-print(format(spare, '5d'), format(100.0*float(spare)/float(list[4]), '.1f')+'% free')
\ No newline at end of file
+# .map areas grouped by memory type
+AREAS = {
+    'code': ('HOME', 'GSINIT', 'GSFINAL', 'CSEG', 'CONST', 'CABS', 'XINIT', 'RSEG'),
+    'xdata': ('XSEG', 'PSEG', 'XISEG', 'XABS'),
+    'data': ('DSEG', 'ISEG', 'OSEG', 'BSEG', 'IABS', 'DABS'),
+}
+
+
+def parse_mem(name):
+    ''' returns dict with memory usage, memory lines are found by names, not line numbers '''
+    with open(name) as file:
+        lines = file.readlines()
+
+    # ram will hold the string with the RAM layout - 16 rows of 16 cells
+    ram = ''
+    for line in lines:
+        m = re.match(r'^0x[0-9a-fA-F]0:((\|.){16})', line)
+        if m:
+            ram += m.group(1)
+    if len(ram) != IDATA_MAX * 2:
+        raise ValueError('internal RAM layout is not found in ' + name)
+
+    # count reg banks, bank 0 always in use
+    banks = 1
+    # get the max index of the used reg bank
+    if ram.count('|3'):
+        banks = 4
+    elif ram.count('|2'):
+        banks = 3
+    elif ram.count('|1'):
+        banks = 2
+
+    usage = {
+        'banks': banks,
+        'overlays': ram.count('|Q'),
+        'stack': ram.count('|S'),
+    }
+    usage['idata'] = IDATA_MAX - usage['stack']
+
+    # other memory lines: name, optional start and end addresses, size and max
+    for line in lines:
+        for key, title in (('xram', 'EXTERNAL RAM'), ('rom', 'ROM/EPROM/FLASH')):
+            if line.strip().startswith(title):
+                fields = line.strip()[len(title):].split()
+                addr = [f for f in fields if f.lower().startswith('0x')]
+                nums = [int(f) for f in fields if f.isdigit()]
+                usage[key] = {
+                    'start': addr[0] if len(addr) > 0 else '',
+                    'end': addr[1] if len(addr) > 1 else '',
+                    'size': nums[-2],
+                    'max': nums[-1],
+                }
+    for key in ('xram', 'rom'):
+        if key not in usage:
+            raise ValueError(key + ' line is not found in ' + name)
+    return usage
+
+
+def print_mem(usage):
+    banks = usage['banks']
+    idata = usage['idata']
+    stack = usage['stack']
+
+    print('')
+    print('   Name              Start    End  Size   Max Spare')
+    print('   ---------------- ------ ------ ----- ----- -----------')
+    # registers banks
+    print('   REG BANKS        0x0000 0x' + format(int(banks*8)-1, '04X'), '', end='')
+    print(format(banks, '5d'), format(BANKS_MAX, '5d'), '', end='')
+    print(format(BANKS_MAX - banks, '5d'))
+    # DATA line
+    print('   IDATA            0x0000 0x' + format(int(idata)-1, '04X'), '', end='')
+    print(format(idata, '5d'), format(IDATA_MAX, '5d'), '', end='')
+    print(format(IDATA_MAX - idata, '5d'))
+    # OVERLAYS line
+    if usage['overlays']:
+        print('   OVERLAYS                          ', usage['overlays'])
+    # STACK line
+    print('   STACK            0x' + format(int(idata), '04X'), '0x00FF ', end='')
+    print(format(stack, '5d'), format(STACK_MAX, '5d'), format(stack, '5d'))
+    # EXTERNAL RAM and ROM/EPROM/FLASH lines
+    for key, title in (('xram', 'EXTERNAL RAM    '), ('rom', 'ROM/EPROM/FLASH ')):
+        mem = usage[key]
+        spare = mem['max'] - mem['size']
+        print('  ', title, format(mem['start'], '>6s'), format(mem['end'], '>6s'), '', end='')
+        print(format(mem['size'], '5d'), format(mem['max'], '5d'), '', end='')
+        print(format(spare, '5d'), format(100.0*float(spare)/float(mem['max']), '.1f')+'% free')
+
+
+def parse_map(name):
+    ''' returns list of (area, symbol, module, address, size) from .map file '''
+    areas = {}
+    symbols = []
+    area = None
+    with open(name) as file:
+        for line in file:
+            # area header: "CSEG    00000123    000004A5 =        1189. bytes (REL,CON,CODE)"
+            m = re.match(r'^(\w+)\s+([0-9A-Fa-f]{4,8})\s+([0-9A-Fa-f]{4,8})\s+=\s+(\d+)\.\s+bytes', line)
+            if m:
+                area = m.group(1)
+                start = int(m.group(2), 16)
+                areas[area] = (start, start + int(m.group(4)))
+                continue
+            # symbol: "C:   00000D55  _uart_putc      uart"
+            m = re.match(r'^\s+[A-Z]?:?\s*([0-9A-Fa-f]{4,8})\s+(\S+)\s+(\S+)\s*$', line)
+            if m and area:
+                symbols.append([area, m.group(2), m.group(3), int(m.group(1), 16), 0])
+
+    # size of a symbol is the distance to the next symbol in the same area
+    symbols.sort(key=lambda s: (s[0], s[3]))
+    for i, sym in enumerate(symbols):
+        end = areas[sym[0]][1]
+        if i + 1 < len(symbols) and symbols[i + 1][0] == sym[0]:
+            end = symbols[i + 1][3]
+        sym[4] = max(0, end - sym[3])
+    return symbols
+
+
+def memory_type(area):
+    for key, names in AREAS.items():
+        if area in names:
+            return key
+    return None
+
+
+def modules_usage(symbols):
+    modules = {}
+    for area, _, module, _, size in symbols:
+        key = memory_type(area)
+        if key:
+            usage = modules.setdefault(module, {'code': 0, 'xdata': 0, 'data': 0})
+            usage[key] += size
+    return modules
+
+
+def print_modules(modules):
+    print('')
+    print('   Module                  Code XDATA  DATA')
+    print('   -------------------- ------ ----- -----')
+    for module in sorted(modules, key=lambda m: -modules[m]['code']):
+        u = modules[module]
+        print('   %-20s %6d %5d %5d' % (module, u['code'], u['xdata'], u['data']))
+
+
+def print_functions(symbols):
+    print('')
+    print('   Function                         Module                Size')
+    print('   -------------------------------- -------------------- -----')
+    funcs = [s for s in symbols if memory_type(s[0]) == 'code' and s[4]]
+    for area, symbol, module, _, size in sorted(funcs, key=lambda s: -s[4]):
+        print('   %-32s %-20s %5d' % (symbol, module, size))
+
+
+def compare(report, baseline, threshold):
+    ''' returns number of memory types grown more than threshold bytes '''
+    failed = 0
+    for image, usage in report.items():
+        base = baseline.get(image)
+        if not base:
+            continue
+        for key, value, old in (('code', usage['rom']['size'], base['rom']['size']),
+                                ('xdata', usage['xram']['size'], base['xram']['size']),
+                                ('idata', usage['idata'], base['idata'])):
+            if value - old > threshold:
+                print('%s: %s grows %d -> %d bytes' % (image, key, old, value))
+                failed += 1
+    return failed
+
+
+def main():
+    parser = argparse.ArgumentParser(description='mcs51 memory usage from sdcc .mem/.map files')
+    parser.add_argument('mem', nargs='+', help='.mem file generated by the linker')
+    parser.add_argument('--modules', action='store_true', help='per module usage from .map')
+    parser.add_argument('--functions', action='store_true', help='per function code size from .map')
+    parser.add_argument('--baseline', help='JSON report to compare with')
+    parser.add_argument('--save', action='store_true', help='update the baseline file')
+    parser.add_argument('--threshold', type=int, default=32,
+                        help='allowed growth in bytes, default 32')
+    args = parser.parse_args()
+
+    report = {}
+    for name in args.mem:
+        try:
+            usage = parse_mem(name)
+        except (IOError, ValueError) as e:
+            print('Could not read file:', name, e)
+            sys.exit(1)
+        if len(args.mem) > 1:
+            print('\n' + name)
+        print_mem(usage)
+
+        mapname = os.path.splitext(name)[0] + '.map'
+        if (args.modules or args.functions or args.baseline) and os.path.exists(mapname):
+            symbols = parse_map(mapname)
+            usage['modules'] = modules_usage(symbols)
+            if args.modules:
+                print_modules(usage['modules'])
+            if args.functions:
+                print_functions(symbols)
+        # images are identified by the sample folder name
+        report[os.path.basename(os.path.dirname(os.path.abspath(name)))] = usage
+
+    if not args.baseline:
+        return
+    baseline = {}
+    if os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+    failed = compare(report, baseline, args.threshold)
+    if args.save or not baseline:
+        baseline.update(report)
+        with open(args.baseline, 'w') as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+            f.write('\n')
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
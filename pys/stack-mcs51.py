@@ -0,0 +1,238 @@
+# The MIT License (MIT)
+#
+# worst case stack depth for mcs51 target from .asm files generated by sdcc
+# checked on hand-written .asm only, not tested with real sdcc output yet
+#
+# Every function of the passed .asm files is scanned for push/pop, inc/dec sp
+# and "mov sp,a" frame adjustments of __reentrant functions and for calls.
+# The call graph is walked from main() and from every interrupt handler
+# (function returning with reti). Return addresses take 2 bytes per call and
+# an interrupt entry takes 2 bytes more. Handlers of the same priority level
+# can not preempt each other, so the worst case is main() plus the deepest
+# handler of every level used. Priorities are set with --priority, all the
+# bsp handlers run at level 0 by default.
+#
+# Indirect calls through __sdcc_call_dptr are counted as a call to the deepest
+# function with its address taken (mov r,#_func). Functions without .asm, like
+# sdcc library helpers __mulint or __gptrget, take --unknown bytes.
+#
+#  > stack-mcs51.py --mem main.mem main.asm ../../bsp/uart.asm ...
+#
+# will output
+#
+#   Root                             Level Depth
+#   -------------------------------- ----- -----
+#   main                                      21
+#   uart_interrupt_handler               0    15
+#   tick_interrupt_handler               0    11
+#
+#   main: main(2) > cli_interact(4) > ... = 21
+#   level 0: uart_interrupt_handler(7) > event_put(2) > ... = 15
+#
+#   Worst case stack depth 36 bytes, 173 bytes available
+#
+# exits with 1 if the worst case does not fit into the stack from .mem file
+
+import argparse
+import os
+import re
+import sys
+
+# return address pushed by lcall/acall and by an interrupt entry
+RET_ADDR = 2
+
+
+class Function:
+    def __init__(self, module, name):
+        self.module = module
+        self.name = name
+        self.frame = 0      # max bytes pushed by the function itself
+        self.calls = []     # (callee name, bytes pushed at the call, tail jump)
+        self.isr = False
+        self.depth = None
+        self.path = []
+
+
+def parse_asm(name, functions, globs, taken):
+    ''' adds functions of one .asm file to functions[(module, label)] '''
+    module = os.path.splitext(os.path.basename(name))[0]
+    func = None
+    pending = None
+    declared = set()
+    cur = 0
+    mov_sp = None
+    with open(name) as file:
+        for line in file:
+            code = line.split(';', 1)[0].strip()
+            m = re.match(r';\s+function\s+(\w+)', line.strip())
+            if m:
+                pending = '_' + m.group(1)
+                continue
+            m = re.match(r'\.globl\s+(_\w+)', code)
+            if m:
+                declared.add(m.group(1))
+                continue
+            m = re.match(r'^(\w+):', code)
+            if m and m.group(1) == pending:
+                func = Function(module, pending)
+                functions[(module, pending)] = func
+                if pending in declared:
+                    globs[pending] = module
+                pending = None
+                cur = 0
+                continue
+            if func is None or not code:
+                continue
+
+            op = code.split(None, 1)
+            args = op[1].replace(' ', '') if len(op) > 1 else ''
+            op = op[0].lower()
+            if op == 'push' or (op == 'inc' and args == 'sp'):
+                cur += 1
+            elif op == 'pop' or (op == 'dec' and args == 'sp'):
+                cur = max(0, cur - 1)
+            elif op == 'mov' and args == 'a,sp':
+                mov_sp = 0
+            elif op == 'add' and mov_sp is not None and args.startswith('a,#'):
+                mov_sp = int(args[3:], 0) & 0xFF
+            elif op == 'mov' and args == 'sp,a' and mov_sp is not None:
+                # the same 8 bit addition as the code does
+                cur = max(0, cur + (mov_sp if mov_sp < 0x80 else mov_sp - 0x100))
+                mov_sp = None
+            elif op in ('lcall', 'acall'):
+                func.calls.append((args, cur, False))
+            elif op in ('ljmp', 'ajmp') and args.startswith('_'):
+                func.calls.append((args, cur, True))
+            elif op == 'reti':
+                func.isr = True
+            else:
+                for sym in re.findall(r'#\(?(_\w+)', args):
+                    taken.add(sym)
+            if op not in ('mov', 'add'):
+                mov_sp = None
+            func.frame = max(func.frame, cur)
+
+
+def resolve(functions, globs, module, label):
+    if (module, label) in functions:
+        return functions[(module, label)]
+    if label in globs and (globs[label], label) in functions:
+        return functions[(globs[label], label)]
+    return None
+
+
+def walk(func, functions, globs, indirect, unknown, active, missing, recursion):
+    ''' returns worst stack depth of func and saves its path '''
+    if func.depth is not None:
+        return func.depth
+    if func in active:
+        recursion.add(func.name[1:])
+        return 0
+    active.add(func)
+    func.depth = func.frame
+    func.path = [func]
+    for label, pushed, tail in func.calls:
+        ret = 0 if tail else RET_ADDR
+        if label == '__sdcc_call_dptr':
+            callees = indirect
+        else:
+            callee = resolve(functions, globs, func.module, label)
+            if callee is None:
+                if not tail:
+                    missing.add(label)
+                    func.depth = max(func.depth, pushed + ret + unknown)
+                continue
+            callees = [callee]
+        for callee in callees:
+            depth = pushed + ret + walk(callee, functions, globs, indirect, unknown,
+                                        active, missing, recursion)
+            if depth > func.depth:
+                func.depth = depth
+                func.path = [func] + callee.path
+    active.discard(func)
+    return func.depth
+
+
+def path_str(func, depth):
+    return ' > '.join('%s(%d)' % (f.name[1:], f.frame) for f in func.path) + ' = %d' % depth
+
+
+def stack_available(name):
+    ''' "Stack starts at: 0x53 (sp set to 0x52) with 173 bytes available." '''
+    with open(name) as file:
+        for line in file:
+            m = re.search(r'with\s+(\d+)\s+bytes\s+available', line)
+            if m:
+                return int(m.group(1))
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description='mcs51 worst case stack depth from sdcc .asm files')
+    parser.add_argument('asm', nargs='+', help='.asm files of all linked modules')
+    parser.add_argument('--mem', help='.mem file to check the available stack')
+    parser.add_argument('--priority', action='append', default=[],
+                        help='interrupt handler priority level, e.g. pwm_interrupt_handler=1')
+    parser.add_argument('--unknown', type=int, default=4,
+                        help='stack bytes of functions without .asm, default 4')
+    args = parser.parse_args()
+
+    functions = {}
+    globs = {}
+    taken = set()
+    for name in args.asm:
+        if not os.path.exists(name):
+            print('Skip missing file:', name)
+            continue
+        parse_asm(name, functions, globs, taken)
+
+    levels = {}
+    for p in args.priority:
+        name, level = p.split('=')
+        levels['_' + name] = int(level)
+
+    indirect = [f for f in functions.values() if f.name in taken and not f.isr]
+    missing = set()
+    recursion = set()
+    roots = [f for f in functions.values() if f.name == '_main']
+    roots += sorted([f for f in functions.values() if f.isr], key=lambda f: f.name)
+    if not roots:
+        print('main() and interrupt handlers are not found')
+        sys.exit(1)
+
+    print('')
+    print('   Root                             Level Depth')
+    print('   -------------------------------- ----- -----')
+    worst = {}
+    for f in roots:
+        depth = RET_ADDR + walk(f, functions, globs, indirect, args.unknown, set(), missing, recursion)
+        level = levels.get(f.name, 0) if f.isr else None
+        print('   %-32s %5s %5d' % (f.name[1:], '' if level is None else level, depth))
+        if level not in worst or depth > worst[level][0]:
+            worst[level] = (depth, f)
+
+    print('')
+    total = 0
+    for level in sorted(worst, key=lambda x: -1 if x is None else x):
+        depth, f = worst[level]
+        total += depth
+        print('  ', 'main:' if level is None else 'level %d:' % level, path_str(f, depth))
+    if missing:
+        print('   no .asm for:', ' '.join(sorted(missing)))
+    if indirect:
+        print('   indirect calls:', ' '.join(sorted(f.name[1:] for f in indirect)))
+    if recursion:
+        print('   recursion is not counted:', ' '.join(sorted(recursion)))
+
+    print('')
+    available = stack_available(args.mem) if args.mem else None
+    if available is None:
+        print('   Worst case stack depth %d bytes' % total)
+    else:
+        print('   Worst case stack depth %d bytes, %d bytes available' % (total, available))
+        if total > available:
+            sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
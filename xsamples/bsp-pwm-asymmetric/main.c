@@ -10,6 +10,8 @@
 #include "main.h"
 
 uint8_t adc_duty;
+/* list of ADC channels sampled by the ADC engine */
+static __code const uint8_t adc_channels[] = {ADC_CHANNEL};
 uint8_t pwm_signal_mode = PWM_SIGNAL_INPHASE;
 
 /*
@@ -47,8 +49,6 @@ void main(void)
 
 	uart_init(UART_BR_38400, true);
 
-	/* use AIN1 (P3.0) to get duty value */
-	adc_enable();
 	/* generate EVT_TIMER every 250 msec, 4 times per second */
 	tick_init(250);
 	EA = 1; /* enable all interrupts to start tick timer */
@@ -97,9 +97,12 @@ void main(void)
 	adc_mode_set();
 	P05_Input_Mode; /* our ADC_AIN connected to AIN4 */
 	AINDIDS |= 1 << ADC_CHANNEL;
-	adc_clear();
-	adc_select_channel(ADC_CHANNEL);
-	adc_start();
+	/**
+	 * sample on PWM2 falling edge at the PWM period centre, away from
+	 * the OUT1/OUT2 switching, and average 4 periods per EVT_ADC
+	 */
+	PWM2_FALLINGEDGE_TRIG_ADC;
+	adc_engine_start(adc_channels, sizeof(adc_channels), 2, ADC_EXT_TRIGGER);
 
 	/** PWM configuration stop ************************************************/
 	/* events processing loop */
@@ -111,7 +114,7 @@ void main(void)
 				continue;
 			}
 			if (evt.type == EVT_TICK) {
-				tick++;
+				tick += evt.data;
 				/* we have 4 tick events per second, so count to 4 before calling our timer handler */
 				if (tick >= 4) {
 					timer();
@@ -119,14 +122,12 @@ void main(void)
 				}
 				continue;
 			}
-		}
-
-		if (adc_done()) {
-			adc_duty = adc_read() / 40;
-			if (adc_mode_get())
-				pwm_set_signal_duty(0, adc_duty);
-			adc_clear();
-			adc_start();
+			if (evt.type == EVT_ADC) {
+				adc_duty = adc_engine_avg(0) / 40;
+				if (adc_mode_get())
+					pwm_set_signal_duty(0, adc_duty);
+				continue;
+			}
 		}
 	}
 }
@@ -24,6 +24,9 @@ const __code char cmd_list[] =
 	"gpmode [enable|disable]\n"								   /* group mode */
 	"inttype [rise|fall|center|end|period]\n"				   /* PWM interrupt type, 'period' - sw */
 	"opmode [independent|complementary|synchronized|phased]\n" /* operation mode, 'phased' - sw */
+#ifdef USE_PROF
+	"prof [reset]\n"											   /* ISRs and main loop timings */
+#endif
 	"phases [$start $end]\n"								   /* get/set channels for phases range */
 	"shift [0-255]\n"										   /* phased opmode shift between phased */
 	;
@@ -187,6 +190,7 @@ int8_t commander(__idata char *cmd) {
 			set_opmode_phased();
 			PMEN = 0x3F; /* mask off all outputs */
 			PMD = 0x00;	 /* set all outputs to 0, interrupt will driver them up */
+			phases_update();
 			goto EOK;
 		} else
 			return CLI_EARG;
@@ -347,6 +351,7 @@ int8_t commander(__idata char *cmd) {
 			goto EARG;
 		pmd_start = 1 << val.u8low;
 		pmd_end = 1 << val.u8high;
+		phases_update();
 		goto EOK;
 	}
 
@@ -360,6 +365,7 @@ int8_t commander(__idata char *cmd) {
 		if (val.u8high)
 			goto EARG;
 		phase_shift = val.u8low;
+		phases_update();
 		goto EOK;
 	}
 
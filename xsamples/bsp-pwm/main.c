@@ -5,6 +5,7 @@
 #include <event.h>
 #include <uart.h>
 #include <terminal.h>
+#include <prof.h>
 
 
 #include "main.h"
@@ -46,6 +47,7 @@ void main(void)
 
 	/* generate EVT_TIMER every 250 msec, 4 times per second */
 	tick_init(250);
+	prof_init(); /* Timer 2 is used for profiling */
 	eni(); /* enable all interrupts to start tick timer */
 
 	/**
@@ -81,7 +83,7 @@ void main(void)
 	PMEN = 0x3F; /* mask off all outputs */
 	PMD = 0x00;	 /* set all outputs to 0, interrupt will drive them up */
 
-	sti_pwm(); /* enable PWM interrupt */
+	phases_update(); /* enables PWM interrupt */
 	pwm_load();
 	pwm_start();
 
@@ -89,21 +91,21 @@ void main(void)
 	/* events processing loop */
 	while (1) {
 		evt.evt = event_get();
-		if (evt.type) {
-			if (evt.type == EVT_UART_RX) {
-				cli_interact(evt.data);
-				continue;
-			}
-			if (evt.type == EVT_TICK) {
-				tick++;
-				/* we have 4 tick events per second, so count to 4 before calling our timer handler */
-				if (tick >= 4) {
-					timer();
-					tick = 0;
-				}
-				continue;
+		if (evt.type == EVT_NONE)
+			continue;
+		/* idle polls are not profiled */
+		PROF_ENTER();
+		if (evt.type == EVT_UART_RX)
+			cli_interact(evt.data);
+		else if (evt.type == EVT_TICK) {
+			tick += evt.data;
+			/* we have 4 tick events per second, so count to 4 before calling our timer handler */
+			if (tick >= 4) {
+				timer();
+				tick = 0;
 			}
 		}
+		PROF_EXIT(PROF_MAIN);
 	}
 }
 
@@ -111,24 +113,44 @@ uint8_t pmd_start = 0x01; /* default start channel 0 */
 uint8_t pmd_end = 0x04;	  /* default end channel 3 */
 uint8_t phase_shift = 0;  /* default shift between channel 0 periods */
 
-static uint8_t pmd = 0x01; /* current PWM Mask Data */
-static uint8_t phase_clock;
+/* one table is played while the other one is rebuilt */
+static __xdata pwm_step_t phase_steps[2][PWM_NUM_CHANNELS * 2];
+static __xdata pwm_seq_t phase_seq[2];
 
-void pwm_interrupt_handler(void) INTERRUPT(IRQ_PWM, IRQ_PWM_REG_BANK)
+/** 'phased' mode table: one interrupt per channel and phase_shift interrupts off */
+void phases_update(void)
 {
-	MARK_ON;
-
-	if (is_opmode_phased()) { /* 'phase' mode */
-		if (phase_clock == 1) {
-			PMD = 0; /* turn off current PWD output */
-			pmd <<= 1;
-			if (pmd > pmd_end)
-				pmd = pmd_start;
+	uint8_t pmd, n = 0;
+	uint8_t i = 0;
+
+	pwm_seq_queue(NULL); /* a queued table is not taken after this point */
+	if (pwm_seq_playing() == &phase_seq[0])
+		i = 1;
+	for (pmd = pmd_start; pmd <= pmd_end; pmd <<= 1) {
+		phase_steps[i][n].pmd = pmd;
+		phase_steps[i][n].duty = PWM_SEQ_KEEP;
+		phase_steps[i][n++].count = 1;
+		if (phase_shift) {
+			phase_steps[i][n].pmd = 0;
+			phase_steps[i][n].duty = PWM_SEQ_KEEP;
+			phase_steps[i][n++].count = phase_shift;
 		}
 	}
+	phase_seq[i].steps = phase_steps[i];
+	phase_seq[i].duties = NULL;
+	phase_seq[i].num = n;
+	phase_seq[i].channels = 0;
+
+	if (pwm_seq_playing() == NULL)
+		pwm_seq_start(&phase_seq[i]);
+	else
+		pwm_seq_queue(&phase_seq[i]); /* replaces the played table after its last step */
+}
 
-	if (phase_clock > phase_shift)
-		phase_clock = 0;
+void pwm_interrupt_handler(void) INTERRUPT(IRQ_PWM, IRQ_PWM_REG_BANK)
+{
+	MARK_ON;
+	PROF_ENTER();
 
 	PWMF = 0; /* clear interrupt before applying new type */
 
@@ -138,16 +160,10 @@ void pwm_interrupt_handler(void) INTERRUPT(IRQ_PWM, IRQ_PWM_REG_BANK)
 		sfr_page(0);
 	}
 
-	/**
-	 * turn on the next PWM output, instruction above provide
-	 / ~5.8 usec dead time 'period' inttype with phase shift 0
-	 * or ~3.8 usec for dead time for 'end' or 'center' inttype
-	 */
-	if (is_opmode_phased()) {
-		if (phase_clock == 0)
-			PMD = pmd;
-	}
+	/* 'phase' mode: PMD of the next step */
+	if (is_opmode_phased())
+		pwm_seq_step();
 
-	phase_clock++;
+	PROF_EXIT(PROF_PWM);
 	MARK_OFF;
 }
@@ -16,6 +16,7 @@
 
 int8_t commander(__idata char *cmd); /** cli handler */
 void timer(void); /** timer handler called every second if enabled */
+void phases_update(void); /** rebuild 'phased' mode sequence after phases/shift change */
 
 void pwm_interrupt_handler(void) INTERRUPT(IRQ_PWM, IRQ_PWM_REG_BANK);
 
@@ -3,7 +3,7 @@
 #include <tick.h>
 #include <uart.h>
 #include <terminal.h>
-
+#include <spi.h>
 
 #include "main.h"
 
@@ -18,11 +18,16 @@ const __code char cmd_list[] =
 	"spi spis [0-3]\n"	  /* set/get SPI Interval selection between adjacent bytes */
 	"spi write $val\n"	  /* 16bit value for SPI to send */
 	"spi send\n"		  /* send 16 byte sequence 0x00, 0x18, 0x00, ... */
+	"spi irq\n"		  /* send the same sequence by SPI interrupt */
+#ifdef SPI_SLAVE
+	"spi slave\n"		  /* switch to slave mode, print and echo frames */
+#endif
 	;
 
 val16_t val;
 
 __idata uint8_t spibuf[16];
+__xdata uint8_t spixbuf[16];
 
 int8_t commander(__idata char *cmd)
 {
@@ -114,35 +119,41 @@ int8_t commander(__idata char *cmd)
 			arg = get_arg(arg);
 			val.u16 = argtou(arg, &arg);
 			MARK_ON;
-			SPDR = val.u8high;
-			#if 1
-			while (SPSR & SPSR_TXBUF);
-			#else
-			while (!(SPSR & SPSR_SPIF));
-			#endif
-			MARK_OFF;
-			SPDR = val.u8low;
-			while (!(SPSR & SPSR_SPIF));
-			MARK_ON;
-			SPSR &= ~SPSR_SPIF;
+			spibuf[0] = val.u8high;
+			spibuf[1] = val.u8low;
+			spi_write_i(spibuf, 2);
 			MARK_OFF;
+			spi_wait();
+			MARK;
 			goto EOK;
 		}
 		if (str_is(arg, "send")) {
 			for (i = 0; i < 16; i++)
 				spibuf[i] = (i & 0x01) ? 0x18 : 0;
-			__idata uint8_t *buf = spibuf;
-			for (i = 0; i < 16; i++) {
-				SPSR = SPSR_DISMODF;
-				SPDR = *buf++;
-				#if 1
-				while (SPSR & SPSR_TXBUF);
-				#else
-				while (!(SPSR & SPSR_SPIF));
-				#endif
-			}
+			SS_PIN = 0;
+			MARK_ON;
+			spi_write_i(spibuf, 16);
+			MARK_OFF;
+			spi_wait();
+			SS_PIN = 1;
+			goto EOK;
+		}
+		if (str_is(arg, "irq")) {
+			for (i = 0; i < 16; i++)
+				spixbuf[i] = (i & 0x01) ? 0x18 : 0;
+			SS_PIN = 0;
+			MARK_ON;
+			if (!spi_submit(spixbuf, NULL, 16, 0))
+				goto EARG;
+			MARK_OFF;
+			goto EOK; /* EVT_SPI is posted at the end, SS_PIN is set there */
+		}
+#ifdef SPI_SLAVE
+		if (str_is(arg, "slave")) {
+			spi_slave_init(SPCR & SPCR_CPHA);
 			goto EOK;
 		}
+#endif
 		goto EARG;
 	}
 
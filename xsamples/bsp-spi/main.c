@@ -4,7 +4,7 @@
 #include <event.h>
 #include <uart.h>
 #include <terminal.h>
-
+#include <spi.h>
 
 #include "main.h"
 
@@ -28,6 +28,29 @@
  *                 +----------------------+
  */
 
+#ifdef SPI_SLAVE
+void pin_interrupt_handler(void) INTERRUPT(IRQ_PIN, IRQ_PIN_REG_BANK)
+{
+	PIF = 0;
+	spi_slave_ss(); /* the only pin interrupt is SS rising edge */
+}
+
+/** print the received frame and send it back in the next one */
+static void slave_frame(uint8_t len)
+{
+	uint8_t b;
+
+	uart_putsc("spi frame:");
+	while (len--) {
+		b = spi_slave_get();
+		spi_slave_put(b);
+		uart_putc(' ');
+		uart_puth(b);
+	}
+	uart_putc('\n');
+}
+#endif
+
 void main(void)
 {
 	event_t evt;
@@ -43,15 +66,13 @@ void main(void)
 	P1SR |= SET_BIT0; /* SPCLK */
 	sfr_page(0);
 
-	SPSR |= SPSR_DISMODF; /* disable mode fault error flag */
 	/**
 	 * SPI in master mode
 	 * SS as general I/O
 	 * SPCLK to 0 in idle mode
 	 * MSB first
 	 */
-	SPCR = SPCR_MSTR | SPI_CLOCK_8MHZ | SPCR_SPIEN;
-	SPSR &= ~SPSR_SPIF; /* clear SPI complete flag */
+	spi_init(SPI_CLOCK_8MHZ);
 
 	uart_init(UART_BR_38400, true);
 	/**
@@ -83,8 +104,20 @@ void main(void)
 				cli_interact(evt.data);
 				continue;
 			}
+			if (evt.type == EVT_SPI) {
+				SS_PIN = 1;
+				MARK;
+				uart_putsc("spi done\n");
+				continue;
+			}
+#ifdef SPI_SLAVE
+			if (evt.type == EVT_SPI_FRAME) {
+				slave_frame(evt.data);
+				continue;
+			}
+#endif
 			if (evt.type == EVT_TICK) {
-				tick++;
+				tick += evt.data;
 				/* we have 4 tick events per second, so count to 4 before calling our timer handler */
 				if (tick >= 4) {
 					timer();
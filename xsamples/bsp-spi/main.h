@@ -14,6 +14,8 @@
 #define MARK_OFF
 #endif
 
+/** slave select of the other board in master mode, SS input in slave mode */
+#define SS_PIN P15
 
 int8_t commander(__idata char *cmd); /** cli handler */
 void timer(void); /** timer handler called every second if enabled */
@@ -9,10 +9,10 @@
 
 #define APP_VERSION "2103.28"
 
-/* list of supported commands */
+/* list of supported commands, already indented to be sent as is */
 const __code char cmd_list[] =
 	"\n"
-	"reset\n" /* sw reset */
+	"    reset\n" /* sw reset */
 ;
 
 val16_t val;
@@ -29,19 +29,8 @@ int8_t commander(__idata char *cmd)
 		uart_putsc(" bytes)\n");
 
 		uart_putsc("CMD:");
-		__code char *list = cmd_list;
-		for (;; list++) {
-			uint8_t ch = *list;
-			if (ch == 0)
-				break;
-			if (ch == '\n') {
-				uart_putc('\n');
-				uart_putsc("    ");
-				continue;
-			}
-			uart_putc(ch);
-		}
-		uart_putc('\n');
+		/* send the list directly from code memory, without blocking on tx buffer */
+		uart_write_desc((const uint8_t *)cmd_list, sizeof(cmd_list) - 1, 0);
 		goto EOK;
 	}
 
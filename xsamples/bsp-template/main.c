@@ -1,6 +1,7 @@
 #include <N76E003.h>
 
 #include <tick.h>
+#include <timer.h>
 #include <event.h>
 #include <uart.h>
 #include <terminal.h>
@@ -31,7 +32,6 @@
 void main(void)
 {
 	event_t evt;
-	uint8_t tick;
 
 	Set_All_GPIO_Quasi_Mode;
 	MARK_PIN = 0;
@@ -42,11 +42,8 @@ void main(void)
 	sfr_page(0);
 
 	uart_init(UART_BR_38400, true);
-	/**
-	 * generate EVT_TIMER every 250 msec, 4 times per second
-	 * 253 instead of 250 is used because we are running at 16.6MHz
-	 */
-	tick_init(253);
+	/* no EVT_TICK events, software timers are used instead */
+	tick_init(0);
 	EA = 1; /* enable all interrupts to start tick timer */
 
 	/**
@@ -59,7 +56,11 @@ void main(void)
 	cli_exec("help\n"); /* '\n' will put promt sign '>' */
 
 	event_flush(); /* clear any events */
-	tick = 0;
+	/**
+	 * generate EVT_TIMER every second,
+	 * 1012 instead of 1000 is used because we are running at 16.6MHz
+	 */
+	timer_start(TIMER_MAIN, 1012, 1012, EVT_TIMER, 0);
 
 	/* events processing loop */
 	while (1) {
@@ -67,17 +68,19 @@ void main(void)
 		evt.evt = event_get();
 
 		if (evt.type) {
+#ifdef UART_RX_RING
+			if (evt.type == EVT_UART_LINE) {
+				cli_interact_line();
+				continue;
+			}
+#else
 			if (evt.type == EVT_UART_RX) {
 				cli_interact(evt.data);
 				continue;
 			}
-			if (evt.type == EVT_TICK) {
-				tick++;
-				/* we have 4 tick events per second, so count to 4 before calling our timer handler */
-				if (tick >= 4) {
-					timer();
-					tick = 0;
-				}
+#endif
+			if (evt.type == EVT_TIMER) {
+				timer();
 				continue;
 			}
 		}
@@ -14,6 +14,16 @@
 #define MARK_OFF
 #endif
 
+/** application events family */
+enum {
+	EVT_TIMER = 0x10 /** software timer TIMER_MAIN expired */
+};
+
+/** software timers */
+enum {
+	TIMER_MAIN
+};
+
 int8_t commander(__idata char *cmd); /** cli handler */
 void timer(void); /** timer handler called every second if enabled */
 
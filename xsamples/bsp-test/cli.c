@@ -1,6 +1,7 @@
 #include <N76E003.h>
 #include <adc.h>
 #include <i2c.h>
+#include <i2c_queue.h>
 #include <iap.h>
 #include <irq.h>
 #include <tick.h>
@@ -35,6 +36,7 @@ const __code char cmd_list[] =
 	"i2c scan|stop\n"				 /* scan I2C bus for valid addresses */
 	"i2c wr $dev $val [$val ...]\n"  /* write data */
 	"i2c read $dev $addr [$len]\n"	 /* read data with re-start */
+	"i2c aread $dev $addr [$len]\n" /* queue read, result printed on EVT_I2C_STAT */
 	"i2cmem erase [$fill]\n"		 /* erase EEPROM memory using fill character, 0xFF by default */
 	"i2cmem read $addr\n"			 /* read one byte from i2c EEPROM memory */
 	"i2cmem write $addr $val\n"		 /* write one byte to i2c EEPROM memory */
@@ -73,6 +75,7 @@ static void rtc_print_temperature(void);
 #endif
 
 static uint8_t icmd;
+static __xdata uint8_t i2c_reg; /* register address for "i2c aread" */
 
 int8_t test_cli(__idata char *cmd)
 {
@@ -82,6 +85,9 @@ int8_t test_cli(__idata char *cmd)
 	__idata uint16_t addr;
 	__idata char *arg = get_arg(cmd);
 
+	/* most of the commands use blocking I2C calls */
+	i2cq_wait();
+
 #if STORE_CMD_TO_I2CMEM
 	/* write commands history to i2c EEPROM */
 	addr = icmd * CMD_LEN;
@@ -324,6 +330,20 @@ int8_t test_cli(__idata char *cmd)
 			uart_putln();
 			goto EOK;
 		}
+		if (str_is(arg, "aread")) { /* queue read, see i2c_print_xfer() */
+			arg = get_arg(arg);
+			i = argtou(arg, &arg);
+			if (*arg == '\0')
+				goto EARG;
+			i2c_reg = argtou(arg, &arg);
+			n = argtou(arg, &arg);
+			/* tag is 4 bits wide, so up to 15 bytes can be read */
+			if ((n == 0) || (n > I2C_XFER_TAG_MASK))
+				n = 1;
+			if (i2cq_submit(i << 1, &i2c_reg, 1, xbuf, n, n) != I2C_EOK)
+				return CLI_ENODEV;
+			goto EOK;
+		}
 		goto EARG;
 	}
 
@@ -605,7 +625,9 @@ int8_t test_cli(__idata char *cmd)
 		if (*arg == '\0') {
 			i = cfg.flags;
 			cfg.flags |= CFG_OUT_UART;
-			timer();
+			ds3231_read(DS3231_REG_SEC, 3);
+			ds3231_read(DS3231_REG_TEMP_MSB, 2);
+			timer_print();
 			cfg.flags = i;
 			goto EOK;
 		}
@@ -648,9 +670,26 @@ EOK:
 	return CLI_EOK;
 }
 
-void rtc_print_time(void)
+void i2c_print_xfer(uint8_t data)
+{
+	uint8_t status = i2c_xfer_status(data);
+	if (status != I2C_XFER_OK) {
+		uart_putsc("i2c error ");
+		uart_putnl(status);
+		return;
+	}
+	/* "i2c aread" uses number of bytes to read as transaction tag */
+	for (uint8_t i = 0; i < i2c_xfer_tag(data); i++) {
+		uart_putsc(" x");
+		uart_puth(xbuf[i]);
+	}
+	uart_putln();
+	return;
+}
+
+/* print time from the ds3231 buffer */
+static void rtc_put_time(void)
 {
-	ds3231_read(DS3231_REG_SEC, 3);
 	for (uint8_t i = 2;; i--) {
 		uart_puth(ds3231[i]);
 		if (i)
@@ -661,22 +700,45 @@ void rtc_print_time(void)
 	return;
 }
 
-void rtc_print_temperature(void)
+static void rtc_put_temperature(void)
 {
-	ds3231_read(DS3231_REG_TEMP_MSB, 2);
 	uart_putn(ds3231[DS3231_REG_TEMP_MSB]);
 	uart_putsc(".");
 	uart_putn((ds3231[DS3231_REG_TEMP_LSB] >> 6) * 25);
 	return;
 }
 
+void rtc_print_time(void)
+{
+	ds3231_read(DS3231_REG_SEC, 3);
+	rtc_put_time();
+	return;
+}
+
+void rtc_print_temperature(void)
+{
+	ds3231_read(DS3231_REG_TEMP_MSB, 2);
+	rtc_put_temperature();
+	return;
+}
+
 void timer(void)
+{
+	/* the main loop calls timer_print() on EVT_I2C_STAT of the last read */
+	ds3231_aread(DS3231_REG_SEC, 3, I2C_XFER_NOEVT);
+	ds3231_aread(DS3231_REG_TEMP_MSB, 2, TIMER_XFER_TAG);
+	return;
+}
+
+void timer_print(void)
 {
 	uint8_t dht_err;
+
+	i2cq_wait(); /* LCD calls below are blocking I2C */
 	if (cfg.flags & CFG_OUT_UART) {
-		rtc_print_time();
+		rtc_put_time();
 		uart_putc(' ');
-		rtc_print_temperature();
+		rtc_put_temperature();
 		dht_err = dht_read();
 		if (dht_err == DHT_OK) {
 			uart_putsc(" RH: ");
@@ -691,11 +753,8 @@ void timer(void)
 			uart_putsc(" C");
 		}
 		uart_putsc("\n");
-	} else { /* prepare data for LCD below */
-		ds3231_read(DS3231_REG_SEC, 3);
-		ds3231_read(DS3231_REG_TEMP_MSB, 2);
+	} else /* prepare data for LCD below */
 		dht_err = dht_read();
-	}
 #ifdef USE_BV4618_LCD
 	if (cfg.flags & CFG_OUT_LCD) {
 		bv4618_home();
@@ -736,6 +795,9 @@ void timer(void)
 #endif
 #ifdef USE_PCF8574_LCD
 	if (cfg.flags & CFG_OUT_LCD) {
+		/* measure before the screen transaction to keep the bus busy only for writes */
+		uint16_t vdd = adc_get_vdd(ADC_GET_VDD);
+		pcf_begin();
 		pcf_home();
 		for (uint8_t i = 2;; i--) {
 			pcf_puth(ds3231[i]);
@@ -766,8 +828,9 @@ void timer(void)
 		}
 		pcf_line(2);
 		pcf_putsc("Vdd: ");
-		pcf_putn(adc_get_vdd(ADC_GET_VDD));
+		pcf_putn(vdd);
 		pcf_putsc(" mV");
+		pcf_end();
 	}
 #endif
 	return;
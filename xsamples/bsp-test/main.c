@@ -2,12 +2,13 @@
 
 #include <iap.h>
 #include <i2c.h>
+#include <i2c_queue.h>
 #include <tick.h>
 #include <event.h>
 /* compile with "-DUSE_UART=1" to select UART1 instead of the default UART0 */
 #include <uart.h>
 #include <terminal.h>
-#include <pinterrupt.h>
+#include <pindec.h>
 
 #include <dht.h>
 #include <bv4618.h>
@@ -97,8 +98,7 @@ void main(void)
 	i2c_init(I2C_CLOCK_100K, 5, false);
 
 	/* initialize pin interrupt to process PS/2 keyboard */
-	pin_irq_init_port(PIN_IRQ_PORT0);
-	pin_irq_set_pin(KBD_CLOCK_PIN, PIN_IRQ_EDGE | PIN_IRQ_FALL);
+	pindec_init();
 	cli_exec("kbd xf5");   /* stop scancode generation */
 	cli_exec("kbd xf0 1"); /* switch to scancode set 1 with single byte release scan for most of the keys */
 	cli_exec("kbd xf4");   /* start scancode generation */
@@ -131,17 +131,26 @@ void main(void)
 				continue;
 			}
 			if (evt.type == EVT_TICK) {
-				tick ++;
+				tick += evt.data;
 				/* we have 4 tick events per second */
 				/* call timer handler if enabled */
-				if ((cfg.flags & CFG_TIMER_ON) && (tick >= 4)) {
+				/* skip a second if "i2c aread" is still running */
+				if ((cfg.flags & CFG_TIMER_ON) && (tick >= 4) && !i2cq_busy()) {
 					tick = 0;
-					timer(); /* print RTC & DHT */
+					timer(); /* queue RTC reads, printed with DHT by timer_print() */
 				}
 				continue;
 			}
-			if (evt.type & EVT_KBD_SCAN) {
-				kbd_event(evt.type, evt.data);
+			if (evt.type == EVT_I2C_STAT) {
+				if ((i2c_xfer_tag(evt.data) == TIMER_XFER_TAG) &&
+					(i2c_xfer_status(evt.data) == I2C_XFER_OK))
+					timer_print();
+				else
+					i2c_print_xfer(evt.data);
+				continue;
+			}
+			if (evt.type == EVT_PIN_FRAME) {
+				kbd_frame(evt.data);
 				continue;
 			}
 			/* for debugging log unprocessed events to the serial port */
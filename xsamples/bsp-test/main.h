@@ -9,8 +9,12 @@
 /** set pin to high and back to trace a time marker on oscilloscope */
 #define MARK do{MARK_PIN=1;MARK_PIN=0;}while(0)
 
+#define TIMER_XFER_TAG 0 /** EVT_I2C_STAT tag of timer() RTC reads, "i2c aread" uses 1-15 */
+
 int8_t test_cli(__idata char *cmd); /** cli handler */
-void timer(void); /** timer handler called every second if enabled */
+void timer(void); /** timer handler called every second if enabled, queues RTC reads */
+void timer_print(void); /** prints timer() data on EVT_I2C_STAT with TIMER_XFER_TAG */
+void i2c_print_xfer(uint8_t data); /** EVT_I2C_STAT handler */
 void set_rc_trim(uint8_t rctrim); /** update RC trim value */
 
 #endif
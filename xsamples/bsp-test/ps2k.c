@@ -26,7 +26,8 @@
 #include <N76E003.h>
 #include <tick.h>
 #include <uart.h>
-#include <pinterrupt.h>
+#include <pindec.h>
+#include <i2c_queue.h>
 
 #include <bv4618.h>
 #include <pcf8574.h>
@@ -34,114 +35,37 @@
 #include "cfg.h"
 #include "ps2k.h"
 
-static __bit kbd_cmd;	  /** command mode flag */
-static __bit kbd_cmd_ack; /** command ack flag */
-static uint8_t kbd_data;  /** data to send/receive */
-static uint8_t kbd_clock; /** clock counter */
-static uint8_t parity;	  /** parity counter */
+static __bit kbd_reply; /** the next byte is the command reply */
 
-void pin_interrupt_handler(void) INTERRUPT(IRQ_PIN, IRQ_PIN_REG_BANK)
+void kbd_send_cmd(uint8_t cmd)
 {
-	/* send command mode */
-	if (kbd_cmd) {
-		kbd_clock++;
-		if (kbd_clock == 1) { /* start bit */
-			KBD_DATA = 0;
-			goto exit;
-		}
-		if (kbd_clock < 10) { /* sending data out */
-			parity += kbd_data & 0x01;
-			KBD_DATA = kbd_data & 0x01;
-			kbd_data >>= 1;
-			goto exit;
-		}
-		if (kbd_clock == 10) { /* send parity */
-			KBD_DATA = parity & 0x01;
-			goto exit;
-		}
-		if (kbd_clock == 11) { /* stop bit */
-			KBD_DATA = 1;
-			goto exit;
-		}
-		/* kbd_clock == 12: ack bit, KBD_DATA should be 0 */
-		if (KBD_DATA) {
-			event_put(EVT_KBD_ERROR, EVT_KBD_EACK); /* report command ack error */
-			kbd_cmd_ack = 0; /* command was not accepted, no reason to wait for an ack */
-		}
-		kbd_cmd = 0;
-		goto reset;
-	}
-
-	/* receive data mode */
-	if (!kbd_clock) {
-		if (!KBD_DATA) { /* start data bit should be low */
-			kbd_clock++;
-			parity = 1; /* init with 1 to calculate odd parity */
-		} else {
-			event_put(EVT_KBD_ERROR, EVT_KBD_ESTART); /* report start bit error */
-			kbd_cmd_ack = 0; /* reset command ack */
-		}
-		goto exit;
-	}
-	if (kbd_clock < 9) { /* receive data */
-		if (KBD_DATA) {
-			kbd_data |= 1 << (kbd_clock - 1);
-			parity++;
-		}
-		kbd_clock++;
-		goto exit;
-	}
-	if (kbd_clock == 9) { /* check parity bit */
-		if ((parity & 0x01) != KBD_DATA) {
-			event_put(EVT_KBD_ERROR, EVT_KBD_EPARITY); /* report parity error */
-			kbd_cmd_ack = 0;
-			goto reset;
-		}
-		kbd_clock++;
-		goto exit;
-	}
-	if (kbd_clock == 10) {
-		if (KBD_DATA) { /* stop bit should be high for valid transaction */
-			if (kbd_cmd_ack) /* also generate cmd ack event */
-				event_put(EVT_KBD_CMD_ACK, kbd_data);
-			event_put(EVT_KBD_SCAN, kbd_data);
-		}
-		else
-			event_put(EVT_KBD_ERROR, EVT_KBD_ESTOP); /* report stop bit error */
-		kbd_cmd_ack = 0; /* simplified command acknowledgement */
-	}
-reset:
-	kbd_clock = kbd_data = 0;
-exit:
-	PIF = 0;
+	kbd_reply = 1;
+	pindec_ps2_send(cmd);
 }
 
-void kbd_send_cmd(uint8_t cmd)
+uint8_t kbd_cmd_pending(void)
 {
-	cli_pin();
-	parity = 1;
-	kbd_cmd = 1;
-	kbd_cmd_ack = 1; /* wait for ack byte */
-	kbd_clock = 0;
-	kbd_data = cmd;
-
-	/* prepare for start condition */
-	KBD_DATA = 1;
-	KBD_CLOCK = 1;
-	delay_mks(100);
-
-	KBD_CLOCK = 0;
-	delay_mks(100);
-	KBD_DATA = 0;
-
-	/* set clock high so keyboard will take over and generate the clock */
-	KBD_CLOCK = 1;
-	sti_pin();
+	return pindec_ps2_pending();
 }
 
-uint8_t kbd_cmd_pending(void)
+void kbd_frame(uint8_t data)
 {
-	return kbd_cmd_ack;
+	uint8_t len = pindec_len(data);
+
+	/* PS/2 is the only pindec decoder of the sample */
+	if (pindec_is_err(data)) {
+		kbd_reply = 0;
+		kbd_event(EVT_KBD_ERROR, len);
+		return;
+	}
+	while (len--) {
+		data = pindec_get();
+		if (kbd_reply) { /* also generate cmd ack event */
+			kbd_reply = 0;
+			kbd_event(EVT_KBD_CMD_ACK, data);
+		}
+		kbd_event(EVT_KBD_SCAN, data);
+	}
 }
 
 /* the first 64 printable codes for UK keyboard */
@@ -182,6 +106,7 @@ void kbd_event(uint8_t type, uint8_t data)
 				cfg.flags ^= CFG_OUT_UART;
 		}
 		uart_putln();
+		i2cq_wait(); /* LCD calls below are blocking I2C */
 #ifdef USE_BV4618_LCD
 		bv4618_line(3);
 		if (data == 0x81) { /* Esc release code in scan set 1 - clear line */
@@ -203,6 +128,7 @@ void kbd_event(uint8_t type, uint8_t data)
 		}
 #endif
 #ifdef USE_PCF8574_LCD
+		pcf_begin();
 		pcf_line(3);
 		if (data == 0x81) { /* Esc release code in scan set 1 - clear line */
 			pcf_clline();
@@ -223,6 +149,7 @@ void kbd_event(uint8_t type, uint8_t data)
 				}
 			}
 		}
+		pcf_end();
 #endif
 		if (data == 0x81) /* Esc release code in scan set 1 - clear buffer */
 			knum = kidx = 0;
@@ -28,20 +28,20 @@
 
 #include <stdint.h>
 #include <event.h>
+#include <pindec.h>
 
-/* keyboard events */
+/**
+ * keyboard events, PS/2 bits are decoded by bsp/pindec.c,
+ * clock and data pins are set in Makefile
+ */
 #define EVT_KBD_SCAN 	0x80 /** scan code event */
 #define EVT_KBD_ERROR 	0x81 /** error event */
-	#define EVT_KBD_EPARITY 0x00
-	#define EVT_KBD_EACK	0x01
-	#define EVT_KBD_ESTART	0x02
-	#define EVT_KBD_ESTOP	0x03
+	#define EVT_KBD_EPARITY PINDEC_EPARITY
+	#define EVT_KBD_EACK	PINDEC_EACK
+	#define EVT_KBD_ESTART	PINDEC_ESTART
+	#define EVT_KBD_ESTOP	PINDEC_ESTOP
 #define EVT_KBD_CMD_ACK	0x82 /** command ack event */
 
-#define KBD_CLOCK_PIN 4
-#define KBD_CLOCK P04 /** ps2 clock pin */
-#define KBD_DATA  P03 /** ps2 data pin */
-
 /* most common command */
 #define KBD_CMD_LED 	0xED /* expects argument - LED lock mask */
 	#define KBD_LED_SCROLL  0x01
@@ -65,6 +65,9 @@ void kbd_send_cmd(uint8_t cmd);
 /** returns non zero if command is pending */
 uint8_t kbd_cmd_pending(void);
 
+/** EVT_PIN_FRAME handler, calls kbd_event() per received byte or error */
+void kbd_frame(uint8_t data);
+
 /** keyboard event handler */
 void kbd_event(uint8_t type, uint8_t data);
 
@@ -90,7 +90,7 @@ void main(void)
 				continue;
 			}
 			if (evt.type == EVT_TICK) {
-				tick++;
+				tick += evt.data;
 				/* we have 4 tick events per second, so count to 4 before calling our timer handler */
 				if (tick >= 4) {
 					timer();
@@ -41,6 +41,11 @@ int8_t commander(__idata char* cmd)
 		uart_putsc("Vdd: ");
 		uart_putn(adc_get_vdd(ADC_GET_VDD));
 		uart_putsc(" mV\n");
+#ifdef TICK_TICKLESS
+		uart_putsc("WKT: ");
+		uart_putn(tick_wakeups());
+		uart_putsc(" wake-ups/s\n");
+#endif
 
 		uart_putsc("CMD:");
 		__code char *list = cmd_list;
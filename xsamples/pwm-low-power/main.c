@@ -4,6 +4,7 @@
 #include <iap.h>
 #include <pwm.h>
 #include <tick.h>
+#include <pwm_ramp.h>
 #include <event.h>
 #include <uart.h>
 #include <terminal.h>
@@ -220,36 +221,47 @@ void main(void)
 	}
 }
 
+/* fade to the target in idle mode, the ramp is stepped by WKT interrupt */
+static void led_ramp(uint8_t target, uint8_t steps)
+{
+	uint16_t msec = steps * LED_FADE_STEP_MSEC;
+
+	pwm_ramp_start(LED_PWM_CHANNEL, target, msec, PWM_RAMP_GAMMA);
+	idle(msec); /* PWM keeps running in idle mode */
+	while (pwm_ramp_busy()) /* the ramp rounds msec to its points */
+		idle(1);
+}
+
 /* gradually turn on the LED */
 void turn_led_on(uint8_t power)
 {
-	uint8_t i;
-	for (i = 0; i <= power; i++) {
-		pwm_duty_set(LED_PWM_CHANNEL, i);
-		pwm_load();
-		delay(20);
-	}
-
-	return;
+	led_ramp(power, power);
 }
 
 /* gradually turn off the LED */
 void turn_led_off(void)
 {
-	uint8_t i = pwm_duty_get(LED_PWM_CHANNEL);
-
-	for (; i > 0; i--) {
-		pwm_duty_set(LED_PWM_CHANNEL, i);
-		pwm_load();
-		delay(20);
-	}
-
-	return;
+	led_ramp(0, pwm_duty_get(LED_PWM_CHANNEL));
 }
 
 uint16_t get_vdd(void)
 {
+#ifdef ADC_VDD_ASYNC
+	adc_vdd_start();
+	/* idle until the ADC interrupt, one more instruction is always executed
+	   after EA write before an interrupt, so the wake-up can not be missed */
+	while (1) {
+		EA = 0;
+		if (!adc_vdd_busy())
+			break;
+		EA = 1;
+		set_IDL;
+	}
+	EA = 1;
+	return adc_vdd_result() / 10;
+#else
 	return adc_get_vdd(ADC_GET_VDD) / 10;
+#endif
 }
 
 #if LED_POWER_USE_MAP
@@ -23,6 +23,7 @@ void timer(void); /** timer handler called every second if enabled */
 #define PWM_PERIOD 100
 #define SLEEP_TIMER_PIN P30
 #define LED_PWM_CHANNEL 0
+#define LED_FADE_STEP_MSEC 20 /* LED fade in/out duration per duty percent */
 
 #define set_state(STATE) do { state = STATE; P01 = SLEEP_TIMER_PIN; P13 = STATE & 0x01; P14 = STATE >> 1; } while(0)
 
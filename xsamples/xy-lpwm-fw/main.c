@@ -115,6 +115,7 @@ void main(void)
 	lcd_printn(evt.evt, 0, 4);
 	lcd_set_sign(LCD_SIG_DOT0, true);
 	lcd_set_sign(LCD_SIG_V, true);
+	lcd_flush();
 	delay(2500);
 
 	/* clear screen and events */
@@ -131,6 +132,12 @@ void main(void)
 
 	/* read and process events */
 	while(1) {
+#ifdef PWM_SHADOW
+		/* load PWM values staged while the previous LOAD was pending */
+		pwm_shadow_commit();
+#endif
+		/* one LCD transaction for all changes of the previous event */
+		lcd_flush();
 		evt.evt = event_get();
 
 		if (evt.type) {
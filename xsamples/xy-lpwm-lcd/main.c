@@ -108,6 +108,7 @@ void main(void)
 	lcd_set_sign(LCD_SIG_DOT0, true);
 	lcd_set_sign(LCD_SIG_V, true);
 	lcd_set_sign(LCD_SIG_PERCENT, true);
+	lcd_flush();
 	delay(2500);
 
 	/* clear screen and events */
@@ -120,6 +121,12 @@ void main(void)
 
 	/* read and process events */
 	while(1) {
+#ifdef PWM_SHADOW
+		/* load PWM values staged while the previous LOAD was pending */
+		pwm_shadow_commit();
+#endif
+		/* lib/lcd_lpwm.rel can be built with LCD_FLUSH for xy-lpwm-fw */
+		lcd_flush();
 		evt.evt = event_get();
 
 		if (evt.type) {